@@ -27,15 +27,23 @@
  * The program processes the direction string and outputs the total number of
  * unique houses that receive at least one present.
  *
+ * The walk is decoded into move codes 32 characters at a time and the houses
+ * are kept as packed 64-bit keys, in a bitmap over the bounding box when it is
+ * small enough and in an open-addressing hash set otherwise. An optional second
+ * argument sets the number of couriers taking turns (1 by default).
+ *
  * Puzzle Answer: [Total Number of Houses Receiving at Least One Present]
  *
  * @author [gabrielzschmitz]
  * @date [23/08/2024]
  */
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <immintrin.h>
 #include <iostream>
-#include <set>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -48,40 +56,207 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
+const int COURIERS = 1;
+
+enum Move : uint8_t { North, South, East, West };
+
+const int DX[] = {0, 0, 1, -1};
+const int DY[] = {1, -1, 0, 0};
+
+/* Appends the moves in [from, to) of directions, skipping anything else. */
+void decodeScalar(const char* directions, size_t from, size_t to,
+                  std::vector<uint8_t>& moves) {
+  for (size_t i = from; i < to; i++)
+    switch (directions[i]) {
+      case '^': moves.push_back(North); break;
+      case 'v': moves.push_back(South); break;
+      case '>': moves.push_back(East); break;
+      case '<': moves.push_back(West); break;
+      default: break;
+    }
+}
+
+/*
+ * Classifies 32 characters at a time: blocks made only of arrows are turned
+ * into move codes with byte compares, anything else goes through the scalar
+ * decoder. Built for AVX2 and only called when the CPU has it.
+ */
+__attribute__((target("avx2"))) size_t decodeAvx2(const char* directions,
+                                                  size_t length,
+                                                  std::vector<uint8_t>& moves) {
+  const __m256i north = _mm256_set1_epi8('^'), south = _mm256_set1_epi8('v');
+  const __m256i east = _mm256_set1_epi8('>'), west = _mm256_set1_epi8('<');
+  const __m256i south_code = _mm256_set1_epi8(South);
+  const __m256i east_code = _mm256_set1_epi8(East);
+  const __m256i west_code = _mm256_set1_epi8(West);
+
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i block =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(directions + i));
+    __m256i is_north = _mm256_cmpeq_epi8(block, north);
+    __m256i is_south = _mm256_cmpeq_epi8(block, south);
+    __m256i is_east = _mm256_cmpeq_epi8(block, east);
+    __m256i is_west = _mm256_cmpeq_epi8(block, west);
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(is_north, is_south),
+                                    _mm256_or_si256(is_east, is_west));
+    if (_mm256_movemask_epi8(valid) != -1) {
+      decodeScalar(directions, i, i + 32, moves);
+      continue;
+    }
+    __m256i codes = _mm256_or_si256(
+      _mm256_and_si256(is_south, south_code),
+      _mm256_or_si256(_mm256_and_si256(is_east, east_code),
+                      _mm256_and_si256(is_west, west_code)));
+    size_t size = moves.size();
+    moves.resize(size + 32);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&moves[size]), codes);
+  }
+  return i;
+}
+
+std::vector<uint8_t> decodeMoves(const std::string& directions) {
+  std::vector<uint8_t> moves;
+  moves.reserve(directions.size());
+  size_t decoded = 0;
+  if (__builtin_cpu_supports("avx2"))
+    decoded = decodeAvx2(directions.data(), directions.size(), moves);
+  decodeScalar(directions.data(), decoded, directions.size(), moves);
+  return moves;
+}
+
+/* Calls visit(x, y) for every house, moves being dealt round-robin. */
+template <typename Visit>
+void walk(const std::vector<uint8_t>& moves, int couriers, Visit visit) {
+  std::vector<int64_t> xs(couriers, 0), ys(couriers, 0);
+  visit(0, 0);
+  int courier = 0;
+  for (uint8_t move : moves) {
+    xs[courier] += DX[move];
+    ys[courier] += DY[move];
+    visit(xs[courier], ys[courier]);
+    if (++courier == couriers) courier = 0;
+  }
+}
+
+/* Linear-probing set of houses, each packed into one 64-bit key. */
+class HouseSet {
+ public:
+  HouseSet() : keys(1024, EMPTY), count(0), has_empty_key(false) {}
+
+  /* Adds the house, returning whether it was new. */
+  bool insert(int64_t x, int64_t y) {
+    uint64_t key = ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    if (key == EMPTY) {
+      bool added = !has_empty_key;
+      has_empty_key = true;
+      return added;
+    }
+    if (2 * (count + 1) > keys.size()) grow();
+    if (!place(key)) return false;
+    count++;
+    return true;
+  }
+
+ private:
+  static const uint64_t EMPTY = ~0ULL;
+  std::vector<uint64_t> keys;
+  size_t count;
+  bool has_empty_key;
+
+  bool place(uint64_t key) {
+    size_t mask = keys.size() - 1;
+    size_t slot = (key * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+    for (; keys[slot] != EMPTY; slot = (slot + 1) & mask)
+      if (keys[slot] == key) return false;
+    keys[slot] = key;
+    return true;
+  }
+
+  void grow() {
+    std::vector<uint64_t> old(keys.size() * 2, EMPTY);
+    old.swap(keys);
+    for (uint64_t key : old)
+      if (key != EMPTY) place(key);
+  }
+};
+
+/* One bit per house of a known bounding box. */
+class HouseBitmap {
+ public:
+  HouseBitmap(int64_t min_x, int64_t min_y, int64_t width, int64_t height)
+      : min_x(min_x), min_y(min_y), width(width),
+        bits((width * height + 63) / 64, 0) {}
+
+  bool insert(int64_t x, int64_t y) {
+    uint64_t index = (y - min_y) * width + (x - min_x);
+    uint64_t bit = 1ULL << (index % 64);
+    if (bits[index / 64] & bit) return false;
+    bits[index / 64] |= bit;
+    return true;
+  }
+
+ private:
+  int64_t min_x, min_y, width;
+  std::vector<uint64_t> bits;
+};
+
+/*
+ * Counts the houses visited by the couriers. A first walk finds the bounding
+ * box; when it is at most a few bits per move the houses go in a bitmap over
+ * it, otherwise in the hash set.
+ */
+uint64_t countHouses(const std::vector<uint8_t>& moves, int couriers) {
+  int64_t min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+  walk(moves, couriers, [&](int64_t x, int64_t y) {
+    min_x = std::min(min_x, x), max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y), max_y = std::max(max_y, y);
+  });
+  int64_t width = max_x - min_x + 1, height = max_y - min_y + 1;
+  if (debug)
+    std::cout << "Bounding box: (" << min_x << ", " << min_y << ") to ("
+              << max_x << ", " << max_y << ")" << std::endl;
+
+  uint64_t total = 0;
+  if ((double)width * height <= 16.0 * moves.size() + (1 << 20)) {
+    HouseBitmap houses(min_x, min_y, width, height);
+    walk(moves, couriers,
+         [&](int64_t x, int64_t y) { total += houses.insert(x, y); });
+  } else {
+    HouseSet houses;
+    walk(moves, couriers,
+         [&](int64_t x, int64_t y) { total += houses.insert(x, y); });
+  }
+  return total;
+}
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int couriers = (argc >= 3) ? std::stoi(argv[2]) : COURIERS;
   checkDebugFlag(user_input, debug);
 
-  std::ifstream input_file(user_input);
+  std::ifstream input_file(user_input, std::ios::binary);
   if (!input_file.is_open()) {
     std::cerr << "FILE " << user_input << " UNAVAILABLE!" << std::endl;
     return 1;
   }
 
-  std::set<std::pair<int, int>> visited_houses;
-  int x = 0, y = 0;
-  visited_houses.insert({x, y});
-
-  char ch;
-  while (input_file.get(ch)) {
-    switch (ch) {
-      case '^': y++; break;
-      case 'v': y--; break;
-      case '>': x++; break;
-      case '<': x--; break;
-      default: break;
-    }
-    visited_houses.insert({x, y});
-
-    if (debug) std::cout << "Moved to: (" << x << ", " << y << ")" << std::endl;
-  }
+  input_file.seekg(0, std::ios::end);
+  std::string directions(input_file.tellg(), '\0');
+  input_file.seekg(0, std::ios::beg);
+  input_file.read(&directions[0], directions.size());
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
+  if (couriers < 1) {
+    std::cerr << "Error: At least one courier is needed!" << std::endl;
+    return 1;
+  }
 
-  int total = visited_houses.size();
+  std::vector<uint8_t> moves = decodeMoves(directions);
+  uint64_t total = countHouses(moves, couriers);
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -22,14 +22,27 @@
  *
  * The program outputs the number of "nice" strings found in the input.
  *
+ * The input is memory mapped and split into batches of whole lines, one per
+ * thread. Each batch is read once in 64-byte blocks whose rule bits (vowels,
+ * double letters, bad pairs) come from byte compares and are summed per line.
+ *
  * Puzzle Answer: [Number of Nice Strings]
  *
  * @author [gabrielzschmitz]
  * @date [25/08/2024]
  */
-#include <fstream>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -43,47 +56,216 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-bool checkThreeVowels(const std::string& str) {
-  int vowel_count = 0;
-  for (char ch : str)
-    if (ch == 'a' || ch == 'e' || ch == 'i' || ch == 'o' || ch == 'u')
-      vowel_count++;
-  return vowel_count >= 3;
+/* Read-only memory map of a whole file. */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) : bytes(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+      if (info.st_size > 0) {
+        void* mapped =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          bytes = static_cast<const char*>(mapped);
+          length = info.st_size;
+        }
+      }
+      // An empty file is open with nothing mapped; a failed mapping is not.
+      opened = info.st_size == 0 || bytes != nullptr;
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool isOpen() const { return opened; }
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+ private:
+  const char* bytes;
+  size_t length;
+  bool opened = false;
+};
+
+struct Tally {
+  uint64_t lines = 0;
+  uint64_t nice = 0;
+};
+
+/*
+ * Per-byte rule bits for 64 bytes of text; the pair rules look at each byte
+ * and the one after it, so a block reads 65 bytes.
+ */
+struct BlockMasks {
+  uint64_t newline;
+  uint64_t vowel;
+  uint64_t double_letter;
+  uint64_t bad_pair;
+};
+
+bool isVowel(char ch) {
+  return ch == 'a' || ch == 'e' || ch == 'i' || ch == 'o' || ch == 'u';
 }
 
-bool checkDoubleLetter(const std::string& str) {
-  for (size_t i = 0; i < str.size() - 1; ++i)
-    if (str[i] == str[i + 1]) return true;
-  return false;
+bool isBadPair(char first, char second) {
+  return (first == 'a' || first == 'c' || first == 'p' || first == 'x') &&
+         second == first + 1;
 }
 
-bool checkBadStrings(const std::string& str) {
-  std::vector<std::string> bad_strings = {"ab", "cd", "pq", "xy"};
-  for (const auto& bad : bad_strings)
-    if (str.find(bad) != std::string::npos) return false;
-  return true;
+BlockMasks classifyBlockScalar(const char* block) {
+  BlockMasks masks = {0, 0, 0, 0};
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = 1ULL << i;
+    char ch = block[i], next = block[i + 1];
+    if (ch == '\n') masks.newline |= bit;
+    if (isVowel(ch)) masks.vowel |= bit;
+    if (ch == next && ch != '\n') masks.double_letter |= bit;
+    if (isBadPair(ch, next)) masks.bad_pair |= bit;
+  }
+  return masks;
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256i loadBytes(const char* at) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+}
+
+AVX2_TARGET inline __m256i bytesEqual(__m256i bytes, char ch) {
+  return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(ch));
+}
+
+/* Joins the byte masks of two 32-byte halves into one bit per byte. */
+AVX2_TARGET inline uint64_t bitsOf(__m256i low, __m256i high) {
+  return (uint32_t)_mm256_movemask_epi8(low) |
+         (uint64_t)(uint32_t)_mm256_movemask_epi8(high) << 32;
+}
+
+/* Builds the same masks with byte compares. Needs AVX2. */
+AVX2_TARGET BlockMasks classifyBlockAvx2(const char* block) {
+  __m256i vowel[2], twin[2], bad[2], newline[2];
+  for (int half = 0; half < 2; half++) {
+    __m256i bytes = loadBytes(block + 32 * half);
+    __m256i next = loadBytes(block + 32 * half + 1);
+    newline[half] = bytesEqual(bytes, '\n');
+    __m256i a_or_e =
+      _mm256_or_si256(bytesEqual(bytes, 'a'), bytesEqual(bytes, 'e'));
+    __m256i i_or_o =
+      _mm256_or_si256(bytesEqual(bytes, 'i'), bytesEqual(bytes, 'o'));
+    vowel[half] = _mm256_or_si256(_mm256_or_si256(a_or_e, i_or_o),
+                                  bytesEqual(bytes, 'u'));
+    twin[half] = _mm256_andnot_si256(newline[half],
+                                     _mm256_cmpeq_epi8(bytes, next));
+    __m256i bad_first = _mm256_or_si256(
+      _mm256_or_si256(bytesEqual(bytes, 'a'), bytesEqual(bytes, 'c')),
+      _mm256_or_si256(bytesEqual(bytes, 'p'), bytesEqual(bytes, 'x')));
+    __m256i successor = _mm256_add_epi8(bytes, _mm256_set1_epi8(1));
+    bad[half] = _mm256_and_si256(bad_first,
+                                 _mm256_cmpeq_epi8(next, successor));
+  }
+  return {bitsOf(newline[0], newline[1]), bitsOf(vowel[0], vowel[1]),
+          bitsOf(twin[0], twin[1]), bitsOf(bad[0], bad[1])};
+}
+
+/*
+ * Counts the lines in [begin, end) and the nice ones among them, in a single
+ * pass of 64-byte blocks: rule bits are summed up to each newline bit. Bytes
+ * up to limit may be read; a block closer to it goes through a padded copy.
+ */
+Tally classifyLines(const char* begin, const char* end, const char* limit) {
+  static BlockMasks (*const classifyBlock)(const char*) =
+    __builtin_cpu_supports("avx2") ? classifyBlockAvx2 : classifyBlockScalar;
+
+  Tally tally;
+  int vowels = 0;
+  bool double_letter = false, bad_pair = false;
+  char padded[65 + 63];
+  for (const char* block = begin; block < end; block += 64) {
+    const char* source = block;
+    if (limit - block < 65) {
+      std::memset(padded, 0, sizeof(padded));
+      std::memcpy(padded, block, limit - block);
+      source = padded;
+    }
+    BlockMasks masks = classifyBlock(source);
+    uint64_t rest = (end - block >= 64) ? ~0ULL : (1ULL << (end - block)) - 1;
+    uint64_t newlines = masks.newline & rest;
+    for (;;) {
+      uint64_t line = newlines ? rest & ((newlines & -newlines) - 1) : rest;
+      vowels += __builtin_popcountll(masks.vowel & line);
+      double_letter |= (masks.double_letter & line) != 0;
+      bad_pair |= (masks.bad_pair & line) != 0;
+      if (!newlines) break;
+
+      tally.lines++;
+      tally.nice += vowels >= 3 && double_letter && !bad_pair;
+      vowels = 0;
+      double_letter = bad_pair = false;
+      uint64_t newline = newlines & -newlines;
+      rest &= ~(newline ^ (newline - 1));
+      newlines &= newlines - 1;
+    }
+  }
+  if (begin < end && end[-1] != '\n') {
+    tally.lines++;
+    tally.nice += vowels >= 3 && double_letter && !bad_pair;
+  }
+  return tally;
+}
+
+/*
+ * Splits the buffer into one batch of whole lines per thread and adds up what
+ * each batch counts.
+ */
+Tally classifyAll(const char* data, size_t size) {
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, size / (1 << 16) + 1);
+  std::vector<const char*> bounds = {data};
+  for (size_t worker = 1; worker < workers; worker++) {
+    const char* cut = std::max(bounds.back(), data + size * worker / workers);
+    const char* newline =
+      static_cast<const char*>(memchr(cut, '\n', data + size - cut));
+    bounds.push_back(newline ? newline + 1 : data + size);
+  }
+  bounds.push_back(data + size);
+
+  std::vector<Tally> tallies(workers);
+  std::vector<std::thread> threads;
+  for (size_t worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      tallies[worker] =
+        classifyLines(bounds[worker], bounds[worker + 1], data + size);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  Tally total;
+  for (const Tally& tally : tallies) {
+    total.lines += tally.lines;
+    total.nice += tally.nice;
+  }
+  return total;
 }
 
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
-  std::ifstream input_file(user_input);
-  if (!input_file.is_open()) {
+  MappedFile input_file(user_input);
+  if (!input_file.isOpen()) {
     std::cerr << "FILE " << user_input << " UNAVAILABLE!" << std::endl;
     return 1;
   }
 
-  int nice = 0;
-  int bad = 0;
-  std::string line;
-
-  while (std::getline(input_file, line)) {
-    if (!(checkThreeVowels(line) && checkDoubleLetter(line) &&
-          checkBadStrings(line)))
-      ++bad;
-    else ++nice;
-  }
+  Tally tally = classifyAll(input_file.data(), input_file.size());
+  uint64_t nice = tally.nice;
+  uint64_t bad = tally.lines - tally.nice;
 
   if (debug)
     std::cout << "total nice: " << nice << ", total bad: " << bad << std::endl;
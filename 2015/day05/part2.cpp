@@ -26,14 +26,29 @@
  * The program processes each string and outputs the total count of nice strings
  * under the new rules.
  *
+ * The input is memory mapped and split into batches of whole lines, one per
+ * thread. Each batch is read once in 64-byte blocks; letters repeating with one
+ * between come from byte compares, and lines with one are checked for a pair
+ * twice with a 26x26 table of first-seen positions.
+ *
  * Puzzle Answer: [Number of Nice Strings]
  *
  * @author [gabrielzschmitz]
  * @date [25/08/2024]
  */
-#include <fstream>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 bool debug = false;
 
@@ -46,39 +61,228 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-bool checkDoubleSkip(const std::string& str) {
-  for (size_t i = 0; i < str.size() - 2; ++i)
-    if (str[i] == str[i + 2]) return true;
-  return false;
+/* Read-only memory map of a whole file. */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) : bytes(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+      if (info.st_size > 0) {
+        void* mapped =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          bytes = static_cast<const char*>(mapped);
+          length = info.st_size;
+        }
+      }
+      // An empty file is open with nothing mapped; a failed mapping is not.
+      opened = info.st_size == 0 || bytes != nullptr;
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool isOpen() const { return opened; }
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+ private:
+  const char* bytes;
+  size_t length;
+  bool opened = false;
+};
+
+struct Tally {
+  uint64_t lines = 0;
+  uint64_t nice = 0;
+};
+
+/*
+ * Per-byte rule bits for 64 bytes of text; a letter repeating with one between
+ * is marked on the first of the three, so a block reads 66 bytes.
+ */
+struct BlockMasks {
+  uint64_t newline;
+  uint64_t double_skip;
+};
+
+BlockMasks classifyBlockScalar(const char* block) {
+  BlockMasks masks = {0, 0};
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = 1ULL << i;
+    if (block[i] == '\n') masks.newline |= bit;
+    if (block[i] == block[i + 2] && block[i] != '\n' && block[i + 1] != '\n')
+      masks.double_skip |= bit;
+  }
+  return masks;
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256i loadBytes(const char* at) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+}
+
+AVX2_TARGET inline __m256i bytesEqual(__m256i bytes, char ch) {
+  return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(ch));
+}
+
+/* Joins the byte masks of two 32-byte halves into one bit per byte. */
+AVX2_TARGET inline uint64_t bitsOf(__m256i low, __m256i high) {
+  return (uint32_t)_mm256_movemask_epi8(low) |
+         (uint64_t)(uint32_t)_mm256_movemask_epi8(high) << 32;
+}
+
+/* Builds the same masks with byte compares. Needs AVX2. */
+AVX2_TARGET BlockMasks classifyBlockAvx2(const char* block) {
+  __m256i newline[2], skip[2];
+  for (int half = 0; half < 2; half++) {
+    __m256i bytes = loadBytes(block + 32 * half);
+    __m256i middle = loadBytes(block + 32 * half + 1);
+    __m256i last = loadBytes(block + 32 * half + 2);
+    newline[half] = bytesEqual(bytes, '\n');
+    __m256i broken =
+      _mm256_or_si256(newline[half], bytesEqual(middle, '\n'));
+    skip[half] = _mm256_andnot_si256(broken, _mm256_cmpeq_epi8(bytes, last));
+  }
+  return {bitsOf(newline[0], newline[1]), bitsOf(skip[0], skip[1])};
+}
+
+/*
+ * Where each of the 26x26 letter pairs was first seen in the current line.
+ * Entries are stamped with the line they belong to, so nothing is cleared
+ * between lines.
+ */
+class PairTable {
+ public:
+  PairTable() : stamp(0) {
+    std::fill(std::begin(seen_line), std::end(seen_line), 0);
+  }
+
+  /* Whether some pair shows up twice without overlapping in [begin, end). */
+  bool hasPairTwice(const char* begin, const char* end) {
+    stamp++;
+    for (const char* at = begin; at + 1 < end; at++) {
+      unsigned first = at[0] - 'a', second = at[1] - 'a';
+      if (first >= 26 || second >= 26) continue;
+      unsigned pair = first * 26 + second;
+      uint32_t position = at - begin;
+      if (seen_line[pair] != stamp) {
+        seen_line[pair] = stamp;
+        first_seen[pair] = position;
+      } else if (position >= first_seen[pair] + 2) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  uint64_t stamp;
+  uint64_t seen_line[26 * 26];
+  uint32_t first_seen[26 * 26];
+};
+
+/*
+ * Counts the lines in [begin, end) and the nice ones among them in one pass of
+ * 64-byte blocks. The repeat-with-one-between bits are gathered up to each
+ * newline bit, and only lines that have one are checked for a repeated pair.
+ * Bytes up to limit may be read; a block closer to it uses a padded copy.
+ */
+Tally classifyLines(const char* begin, const char* end, const char* limit) {
+  static BlockMasks (*const classifyBlock)(const char*) =
+    __builtin_cpu_supports("avx2") ? classifyBlockAvx2 : classifyBlockScalar;
+
+  Tally tally;
+  PairTable pairs;
+  const char* line_start = begin;
+  bool double_skip = false;
+  char padded[66 + 62];
+  for (const char* block = begin; block < end; block += 64) {
+    const char* source = block;
+    if (limit - block < 66) {
+      std::memset(padded, 0, sizeof(padded));
+      std::memcpy(padded, block, limit - block);
+      source = padded;
+    }
+    BlockMasks masks = classifyBlock(source);
+    uint64_t rest = (end - block >= 64) ? ~0ULL : (1ULL << (end - block)) - 1;
+    uint64_t newlines = masks.newline & rest;
+    for (;;) {
+      uint64_t line = newlines ? rest & ((newlines & -newlines) - 1) : rest;
+      double_skip |= (masks.double_skip & line) != 0;
+      if (!newlines) break;
+
+      const char* line_end = block + __builtin_ctzll(newlines);
+      tally.lines++;
+      tally.nice += double_skip && pairs.hasPairTwice(line_start, line_end);
+      line_start = line_end + 1;
+      double_skip = false;
+      uint64_t newline = newlines & -newlines;
+      rest &= ~(newline ^ (newline - 1));
+      newlines &= newlines - 1;
+    }
+  }
+  if (line_start < end) {
+    tally.lines++;
+    tally.nice += double_skip && pairs.hasPairTwice(line_start, end);
+  }
+  return tally;
 }
 
-bool checkPairTwice(const std::string& str) {
-  for (size_t i = 0; i < str.size() - 1; ++i) {
-    std::string pair = str.substr(i, 2);
-    for (size_t j = i + 2; j < str.size() - 1; ++j)
-      if (pair == str.substr(j, 2)) return true;
+/*
+ * Splits the buffer into one batch of whole lines per thread and adds up what
+ * each batch counts.
+ */
+Tally classifyAll(const char* data, size_t size) {
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, size / (1 << 16) + 1);
+  std::vector<const char*> bounds = {data};
+  for (size_t worker = 1; worker < workers; worker++) {
+    const char* cut = std::max(bounds.back(), data + size * worker / workers);
+    const char* newline =
+      static_cast<const char*>(memchr(cut, '\n', data + size - cut));
+    bounds.push_back(newline ? newline + 1 : data + size);
+  }
+  bounds.push_back(data + size);
+
+  std::vector<Tally> tallies(workers);
+  std::vector<std::thread> threads;
+  for (size_t worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      tallies[worker] =
+        classifyLines(bounds[worker], bounds[worker + 1], data + size);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  Tally total;
+  for (const Tally& tally : tallies) {
+    total.lines += tally.lines;
+    total.nice += tally.nice;
   }
-  return false;
+  return total;
 }
 
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
-  std::ifstream input_file(user_input);
-  if (!input_file.is_open()) {
+  MappedFile input_file(user_input);
+  if (!input_file.isOpen()) {
     std::cerr << "FILE " << user_input << " UNAVAILABLE!" << std::endl;
     return 1;
   }
 
-  int nice = 0;
-  int bad = 0;
-  std::string line;
-
-  while (std::getline(input_file, line)) {
-    if (!(checkDoubleSkip(line) && checkPairTwice(line))) ++bad;
-    else ++nice;
-  }
+  Tally tally = classifyAll(input_file.data(), input_file.size());
+  uint64_t nice = tally.nice;
+  uint64_t bad = tally.lines - tally.nice;
 
   if (debug)
     std::cout << "total nice: " << nice << ", total bad: " << bad << std::endl;
@@ -23,23 +23,30 @@
  * The program processes the list of instructions and outputs the total
  * brightness of the grid after all instructions have been executed.
  *
+ * Instructions are parsed once and evaluated on a coordinate-compressed grid,
+ * so the work depends on the number of instructions and not on the grid size,
+ * and coordinates are not limited to 1000x1000.
+ * A second argument of "dense" (optionally followed by the grid size) runs
+ * the brute-force simulation instead, on rows of saturating uint16_t lights.
+ *
  * Puzzle Answer: [Total Brightness]
  *
  * @author [gabrielzschmitz]
  * @date [26/08/2024]
  */
-#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
-#include <functional>
+#include <immintrin.h>
 #include <iostream>
-#include <map>
-#include <ostream>
-#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 bool debug = false;
-const int MAX_GRID = 1000;
 
 void checkDebugFlag(const std::string& input, bool& debug) {
   size_t pos = input.find_last_of('/');
@@ -50,67 +57,268 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-int getLightsOn(const int grid[MAX_GRID][MAX_GRID]) {
-  int total = 0;
-  for (int i = 0; i < MAX_GRID; i++)
-    for (int j = 0; j < MAX_GRID; j++)
-      total += grid[i][j];
-  return total;
+enum Action { TurnOn, TurnOff, Toggle };
+
+struct Instruction {
+  Action action;
+  int64_t x1, y1, x2, y2;
+};
+
+bool parseInstruction(const std::string& command, Instruction& instruction) {
+  size_t offset;
+  if (command.rfind("toggle", 0) == 0) {
+    instruction.action = Toggle;
+    offset = 6;
+  } else if (command.rfind("turn off", 0) == 0) {
+    instruction.action = TurnOff;
+    offset = 8;
+  } else if (command.rfind("turn on", 0) == 0) {
+    instruction.action = TurnOn;
+    offset = 7;
+  } else {
+    return false;
+  }
+
+  char* end;
+  instruction.x1 = std::strtoll(command.c_str() + offset, &end, 10);
+  if (*end != ',') return false;
+  instruction.y1 = std::strtoll(end + 1, &end, 10);
+  const char* through = std::strstr(end, "through");
+  if (through == nullptr) return false;
+  instruction.x2 = std::strtoll(through + 7, &end, 10);
+  if (*end != ',') return false;
+  instruction.y2 = std::strtoll(end + 1, &end, 10);
+
+  if (instruction.x1 > instruction.x2)
+    std::swap(instruction.x1, instruction.x2);
+  if (instruction.y1 > instruction.y2)
+    std::swap(instruction.y1, instruction.y2);
+
+  if (debug) {
+    const char* names[] = {"Turn on", "Turn off", "Toggle"};
+    std::cout << names[instruction.action] << " lights from ("
+              << instruction.x1 << "," << instruction.y1 << ") to ("
+              << instruction.x2 << "," << instruction.y2 << ")\n";
+  }
+  return true;
+}
+
+/* What a stretch of instructions does to brightness b: max(floor, b + add). */
+struct LightEffect {
+  int64_t floor;
+  int64_t add;
+};
+
+const LightEffect NO_EFFECT = {0, 0};
+
+LightEffect effectOf(Action action) {
+  switch (action) {
+    case TurnOn: return {0, 1};
+    case TurnOff: return {0, -1};
+    default: return {0, 2};
+  }
 }
 
-void toggle(int grid[MAX_GRID][MAX_GRID], int x1, int y1, int x2, int y2) {
-  for (int i = y1; i <= y2; i++)
-    for (int j = x1; j <= x2; j++)
-      grid[i][j] += 2;
-  if (debug)
-    std::cout << "Toggle lights from (" << x1 << "," << y1 << ") to (" << x2
-              << "," << y2 << ")\n";
+LightEffect combine(const LightEffect& earlier, const LightEffect& later) {
+  return {std::max(later.floor, earlier.floor + later.add),
+          earlier.add + later.add};
 }
 
-void turnOff(int grid[MAX_GRID][MAX_GRID], int x1, int y1, int x2, int y2) {
-  for (int i = y1; i <= y2; i++)
-    for (int j = x1; j <= x2; j++)
-      if (grid[i][j] > 0) grid[i][j] -= 1;
-  if (debug)
-    std::cout << "Turn off lights from (" << x1 << "," << y1 << ") to (" << x2
-              << "," << y2 << ")\n";
+uint64_t lightValue(const LightEffect& effect) {
+  return std::max(effect.floor, effect.add);
 }
 
-void turnOn(int grid[MAX_GRID][MAX_GRID], int x1, int y1, int x2, int y2) {
-  for (int i = y1; i <= y2; i++)
-    for (int j = x1; j <= x2; j++)
-      grid[i][j] += 1;
-  if (debug)
-    std::cout << "Turn on lights from (" << x1 << "," << y1 << ") to (" << x2
-              << "," << y2 << ")\n";
+/*
+ * Effects applied to one light, as a segment tree over instruction order:
+ * leaves hold the effects of the instructions covering the light and the root
+ * holds their composition in order.
+ */
+class EffectTimeline {
+ public:
+  explicit EffectTimeline(size_t length) : size(1) {
+    while (size < length)
+      size <<= 1;
+    tree.assign(2 * size, NO_EFFECT);
+  }
+
+  void set(size_t time, const LightEffect& effect) {
+    size_t node = size + time;
+    tree[node] = effect;
+    for (node >>= 1; node > 0; node >>= 1)
+      tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+  }
+
+  const LightEffect& total() const { return tree[1]; }
+
+ private:
+  size_t size;
+  std::vector<LightEffect> tree;
+};
+
+size_t compressedIndex(const std::vector<int64_t>& breakpoints, int64_t value) {
+  return std::lower_bound(breakpoints.begin(), breakpoints.end(), value) -
+         breakpoints.begin();
 }
 
-void parseAndExecute(int grid[MAX_GRID][MAX_GRID], const std::string& command) {
-  std::map<std::string,
-           std::function<void(int[MAX_GRID][MAX_GRID], int, int, int, int)>>
-    commandMap = {
-      {"toggle", toggle}, {"turn off", turnOff}, {"turn on", turnOn}};
+/*
+ * Splits the plane at every rectangle edge, so each compressed cell is covered
+ * by the same instructions throughout. Columns are swept left to right keeping
+ * the active instructions; each column is then swept bottom to top, switching
+ * instructions on and off in the timeline, and every cell takes the root
+ * effect weighted by its area. This is O(n^2 log n) for n instructions,
+ * independent of the grid size.
+ */
+uint64_t getLightsOn(const std::vector<Instruction>& instructions) {
+  std::vector<int64_t> xs, ys;
+  for (const Instruction& instruction : instructions) {
+    xs.push_back(instruction.x1);
+    xs.push_back(instruction.x2 + 1);
+    ys.push_back(instruction.y1);
+    ys.push_back(instruction.y2 + 1);
+  }
+  for (auto* breakpoints : {&xs, &ys}) {
+    std::sort(breakpoints->begin(), breakpoints->end());
+    breakpoints->erase(std::unique(breakpoints->begin(), breakpoints->end()),
+                       breakpoints->end());
+  }
+
+  size_t count = instructions.size();
+  std::vector<std::vector<size_t>> starting(xs.size()), ending(xs.size());
+  std::vector<std::pair<size_t, size_t>> rows(count);
+  for (size_t i = 0; i < count; i++) {
+    starting[compressedIndex(xs, instructions[i].x1)].push_back(i);
+    ending[compressedIndex(xs, instructions[i].x2 + 1)].push_back(i);
+    rows[i] = {compressedIndex(ys, instructions[i].y1),
+               compressedIndex(ys, instructions[i].y2 + 1)};
+  }
+
+  EffectTimeline timeline(count);
+  std::vector<bool> active(count, false), applied(count, false);
+  size_t active_count = 0;
+  std::vector<std::pair<size_t, size_t>> events;
+  uint64_t total = 0;
+  for (size_t column = 0; column + 1 < xs.size(); column++) {
+    for (size_t i : ending[column])
+      active[i] = false, active_count--;
+    for (size_t i : starting[column])
+      active[i] = true, active_count++;
+    if (active_count == 0) continue;
 
-  std::string action;
-  int x1, y1, x2, y2;
+    // Events are (row, instruction) with the instruction switched on at its
+    // first row and off again at the row past its last.
+    events.clear();
+    for (size_t i = 0; i < count; i++)
+      if (active[i]) {
+        events.push_back({rows[i].first, i});
+        events.push_back({rows[i].second, i});
+      }
+    std::sort(events.begin(), events.end());
+
+    uint64_t width = xs[column + 1] - xs[column];
+    for (size_t e = 0; e < events.size();) {
+      size_t row = events[e].first;
+      for (; e < events.size() && events[e].first == row; e++) {
+        size_t i = events[e].second;
+        applied[i] = !applied[i];
+        timeline.set(i, applied[i] ? effectOf(instructions[i].action)
+                                   : NO_EFFECT);
+      }
+      if (e < events.size()) {
+        uint64_t height = ys[events[e].first] - ys[row];
+        total += lightValue(timeline.total()) * width * height;
+      }
+    }
+  }
+  return total;
+}
 
-  if (command.find("toggle") == 0) action = "toggle";
-  else if (command.find("turn off") == 0) action = "turn off";
-  else if (command.find("turn on") == 0) action = "turn on";
+const int64_t DEFAULT_DENSE_GRID = 1000;
 
-  std::string coordinates = command.substr(action.length());
-  std::stringstream ss(coordinates);
-  char ignoreChar;  // To ignore the commas and "through"
+uint16_t applyToLight(uint16_t light, Action action) {
+  if (action == TurnOff) return light ? light - 1 : 0;
+  int step = (action == TurnOn) ? 1 : 2;
+  return std::min<int>(UINT16_MAX, light + step);
+}
 
-  ss >> x1 >> ignoreChar >> y1 >> std::ws;
-  ss.ignore(7);
-  ss >> x2 >> ignoreChar >> y2;
+/*
+ * Applies an instruction to lights [from, to) of a row, 16 lights at a time
+ * with saturating adds and subtracts. Built for AVX2 and only called when the
+ * CPU has it.
+ */
+__attribute__((target("avx2"))) void applySpanAvx2(uint16_t* row, size_t from,
+                                                   size_t to, Action action) {
+  const __m256i step = _mm256_set1_epi16((action == Toggle) ? 2 : 1);
+  size_t i = from;
+  for (; i + 16 <= to; i += 16) {
+    __m256i* lights = reinterpret_cast<__m256i*>(row + i);
+    __m256i value = _mm256_loadu_si256(lights);
+    value = (action == TurnOff) ? _mm256_subs_epu16(value, step)
+                                : _mm256_adds_epu16(value, step);
+    _mm256_storeu_si256(lights, value);
+  }
+  for (; i < to; i++)
+    row[i] = applyToLight(row[i], action);
+}
 
-  commandMap[action](grid, x1, y1, x2, y2);
+void applySpan(uint16_t* row, size_t from, size_t to, Action action) {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_avx2) return applySpanAvx2(row, from, to, action);
+  for (size_t i = from; i < to; i++)
+    row[i] = applyToLight(row[i], action);
 }
 
+/*
+ * The brute-force grid for when every light must be simulated: one uint16_t
+ * brightness per light, saturating at both ends.
+ */
+class DenseGrid {
+ public:
+  explicit DenseGrid(int64_t size) : size(size), lights(size * size, 0) {}
+
+  /* Runs every instruction, with each thread owning a band of rows. */
+  void execute(const std::vector<Instruction>& instructions) {
+    int64_t workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<int64_t>(1, std::min(workers, size / 64));
+    std::vector<std::thread> threads;
+    for (int64_t worker = 0; worker < workers; worker++)
+      threads.emplace_back([&, worker] {
+        int64_t first = size * worker / workers;
+        int64_t last = size * (worker + 1) / workers - 1;
+        for (const Instruction& instruction : instructions)
+          applyToRows(instruction, first, last);
+      });
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  uint64_t getLightsOn() const {
+    uint64_t total = 0;
+    for (uint16_t light : lights)
+      total += light;
+    return total;
+  }
+
+ private:
+  int64_t size;
+  std::vector<uint16_t> lights;
+
+  void applyToRows(const Instruction& instruction, int64_t first_row,
+                   int64_t last_row) {
+    int64_t x1 = std::max<int64_t>(instruction.x1, 0);
+    int64_t x2 = std::min(instruction.x2, size - 1);
+    int64_t y1 = std::max(instruction.y1, first_row);
+    int64_t y2 = std::min(instruction.y2, last_row);
+    if (x1 > x2 || y1 > y2) return;
+
+    for (int64_t y = y1; y <= y2; y++)
+      applySpan(&lights[y * size], x1, x2 + 1, instruction.action);
+  }
+};
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  bool dense = (argc >= 3) && std::string(argv[2]) == "dense";
+  int64_t dense_size = (argc >= 4) ? std::stoll(argv[3]) : DEFAULT_DENSE_GRID;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -119,19 +327,27 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  int grid[MAX_GRID][MAX_GRID];
-  std::memset(grid, 0, sizeof(grid));
-
   std::string line;
-  while (std::getline(input_file, line))
-    parseAndExecute(grid, line);
+  std::vector<Instruction> instructions;
+  while (std::getline(input_file, line)) {
+    Instruction instruction;
+    if (parseInstruction(line, instruction))
+      instructions.push_back(instruction);
+  }
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = getLightsOn(grid);
+  uint64_t total;
+  if (dense) {
+    DenseGrid grid(dense_size);
+    grid.execute(instructions);
+    total = grid.getLightsOn();
+  } else {
+    total = getLightsOn(instructions);
+  }
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -30,16 +30,24 @@
  * 2. The total number of characters in the original code representations.
  * 3. The difference between these two totals.
  *
+ * The input is streamed through a fixed buffer in 64-byte blocks. Newlines,
+ * backslashes, quotes and x are found with vector compares, escapes are
+ * resolved with bit arithmetic carried across blocks, and the code, memory and
+ * encoded lengths all come out of the same pass.
+ *
  * Puzzle Answer: [Difference in Characters]
  *
  * @author [gabrielzschmitz]
  * @date [28/08/2024]
  */
-#include <cmath>
+#include <immintrin.h>
+
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -52,58 +60,153 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-std::string encodeString(const std::string& str) {
-  std::string encoded = "\"";
+const size_t READ_CHUNK = 1 << 20;
+
+struct LiteralLengths {
+  uint64_t code = 0;     // characters of the literals as written
+  uint64_t memory = 0;   // characters of the strings they decode to
+  uint64_t encoded = 0;  // characters once escaped and quoted again
+};
+
+/* One bit per byte of a 64-byte block for each character that matters. */
+struct BlockMasks {
+  uint64_t newline;
+  uint64_t backslash;
+  uint64_t quote;
+  uint64_t x;
+};
+
+BlockMasks classifyBlockScalar(const char* block) {
+  BlockMasks masks = {0, 0, 0, 0};
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = 1ULL << i;
+    if (block[i] == '\n') masks.newline |= bit;
+    if (block[i] == '\\') masks.backslash |= bit;
+    if (block[i] == '"') masks.quote |= bit;
+    if (block[i] == 'x') masks.x |= bit;
+  }
+  return masks;
+}
+
+/* Builds the same masks from two 32-byte compares per character. */
+__attribute__((target("avx2"))) BlockMasks classifyBlockAvx2(
+  const char* block) {
+  __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  __m256i high =
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  uint64_t masks[4];
+  const char wanted[4] = {'\n', '\\', '"', 'x'};
+  for (int i = 0; i < 4; i++) {
+    __m256i ch = _mm256_set1_epi8(wanted[i]);
+    masks[i] =
+      (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, ch)) |
+      (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, ch))
+        << 32;
+  }
+  return {masks[0], masks[1], masks[2], masks[3]};
+}
+
+/*
+ * Measures a stream of one-per-line string literals 64 bytes at a time. The
+ * only state carried between blocks is whether the next byte is escaped and
+ * whether a line is open, so blocks can be fed from any buffer.
+ */
+class LiteralScanner {
+ public:
+  /* Scans a 64-byte block of which only the first `valid` bytes count. */
+  void scanBlock(const char* block, int valid) {
+    static BlockMasks (*const classifyBlock)(const char*) =
+      __builtin_cpu_supports("avx2") ? classifyBlockAvx2
+                                     : classifyBlockScalar;
+    BlockMasks masks = classifyBlock(block);
+    uint64_t in_block = (valid == 64) ? ~0ULL : (1ULL << valid) - 1;
+    uint64_t content = ~masks.newline & in_block;
+
+    // Escaped bytes follow an odd run of backslashes: the carry-propagating
+    // add splits runs by the parity of their start.
+    const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    uint64_t backslash = masks.backslash & in_block & ~next_is_escaped;
+    uint64_t follows_escape = (backslash << 1) | next_is_escaped;
+    uint64_t odd_starts = backslash & ~EVEN_BITS & ~follows_escape;
+    unsigned long long even_runs;
+    bool overflow = __builtin_uaddll_overflow(odd_starts, backslash, &even_runs);
+    uint64_t escaped = (EVEN_BITS ^ (even_runs << 1)) & follows_escape;
+    next_is_escaped = (valid == 64) ? overflow : 0;
+
+    uint64_t escapes = masks.backslash & in_block & ~escaped;
+    uint64_t line_starts = content & ~((content << 1) | in_line);
+    in_line = (content >> 63) & 1;
+
+    lines += __builtin_popcountll(line_starts);
+    characters += __builtin_popcountll(content);
+    backslashes += __builtin_popcountll(masks.backslash & in_block);
+    quotes += __builtin_popcountll(masks.quote & in_block);
+    escape_count += __builtin_popcountll(escapes);
+    hex_escapes += __builtin_popcountll(escaped & masks.x & in_block);
+  }
 
-  for (char ch : str) {
-    if (ch == '\\' || ch == '\"') encoded += '\\';
-    encoded += ch;
+  /*
+   * A literal decodes to its characters less the quotes, the backslash of
+   * each escape and the two hex digits of each \x; re-encoding adds quotes
+   * and escapes every backslash and quote.
+   */
+  LiteralLengths lengths() const {
+    LiteralLengths result;
+    result.code = characters;
+    result.memory = characters - 2 * lines - escape_count - 2 * hex_escapes;
+    result.encoded = characters + 2 * lines + backslashes + quotes;
+    return result;
   }
 
-  encoded += "\"";
-  return encoded;
+ private:
+  uint64_t next_is_escaped = 0;
+  uint64_t in_line = 0;
+  uint64_t lines = 0;
+  uint64_t characters = 0;
+  uint64_t backslashes = 0;
+  uint64_t quotes = 0;
+  uint64_t escape_count = 0;
+  uint64_t hex_escapes = 0;
+};
+
+/* Streams the file through a fixed buffer; nothing is allocated per line. */
+bool measureLiterals(std::ifstream& input_file, LiteralLengths& lengths) {
+  LiteralScanner scanner;
+  std::vector<char> buffer(READ_CHUNK + 64);
+  while (input_file) {
+    input_file.read(buffer.data(), READ_CHUNK);
+    size_t size = input_file.gcount();
+    std::memset(buffer.data() + size, 0, 64);
+    for (size_t offset = 0; offset < size; offset += 64)
+      scanner.scanBlock(buffer.data() + offset,
+                        std::min<size_t>(64, size - offset));
+  }
+  if (input_file.bad()) return false;
+  lengths = scanner.lengths();
+  return true;
 }
 
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
-  std::ifstream input_file(user_input);
+  std::ifstream input_file(user_input, std::ios::binary);
   if (!input_file.is_open()) {
     std::cerr << "FILE " << user_input << " UNAVAILABLE!" << std::endl;
     return 1;
   }
 
-  std::string line;
-  int total_code_characters = 0;
-  int total_encoded_characters = 0;
-
-  while (std::getline(input_file, line)) {
-    int code_characters = line.size();
-    std::string encoded_line = encodeString(line);
-    int encoded_characters = encoded_line.size();
-
-    total_code_characters += code_characters;
-    total_encoded_characters += encoded_characters;
-
-    if (debug) {
-      std::cout << "orig: " << line << " -" << code_characters << ""
-                << std::endl;
-      std::cout << "enc : " << encoded_line << " - " << encoded_characters
-                << "\n\n";
-    }
-  }
-
-  if (input_file.bad()) {
+  LiteralLengths lengths;
+  if (!measureLiterals(input_file, lengths)) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
   if (debug)
-    std::cout << "total: " << total_code_characters << " - "
-              << total_encoded_characters << std::endl;
+    std::cout << "total: " << lengths.code << " - " << lengths.encoded
+              << std::endl;
 
-  int total_difference = total_encoded_characters - total_code_characters;
+  uint64_t total_difference = lengths.encoded - lengths.code;
   std::cout << "ANSWER: " << total_difference << std::endl;
 
   return 0;
@@ -20,6 +20,16 @@
  *   1211 → 111221 (one 1, one 2, two 1s)
  *   111221 → 312211 (three 1s, two 2s, one 1)
  *
+ * The digits are produced by a pull-based pipeline: a chain of n stages where
+ * each stage only keeps the run it is currently reading and the few digits it
+ * still has to emit, pulling its input digit by digit from the stage before
+ * it. The whole sequence can therefore be counted or written out with O(n)
+ * memory. Optional arguments:
+ * - `part1 input <file> [digits]` writes the sequence (or its first `digits`
+ *   digits) to `<file>`.
+ * - `part1 input bench` times the pipeline against the recursive string
+ *   version at n=50 and n=60.
+ *
  * The program processes the initial sequence through 40 iterations and outputs
  * the length of the final result.
  *
@@ -28,10 +38,15 @@
  * @author [gabrielzschmitz]
  * @date [30/08/2024]
  */
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -66,9 +81,132 @@ std::string lookAndSay(std::string input, int n) {
   return lookAndSay(newStr, n - 1);
 }
 
+/* Streams the digits of the n-th look-and-say iteration without storing it. */
+class LookAndSayStream {
+ public:
+  LookAndSayStream(const std::string& seed, int n)
+    : seed(seed), seed_pos(0), stages(n) {}
+
+  /* Returns the next digit character, or -1 once the sequence has ended. */
+  int next() { return pull(stages.size()); }
+
+ private:
+  struct Stage {
+    char lookahead = 0;
+    char pending[11];
+    uint8_t pending_pos = 0;
+    uint8_t pending_len = 0;
+    bool exhausted = false;
+  };
+
+  int pull(size_t level) {
+    if (level == 0)
+      return (seed_pos < seed.size()) ? (unsigned char)seed[seed_pos++] : -1;
+
+    Stage& stage = stages[level - 1];
+    if (stage.pending_pos < stage.pending_len)
+      return stage.pending[stage.pending_pos++];
+    if (stage.exhausted) return -1;
+
+    int digit = stage.lookahead ? stage.lookahead : pull(level - 1);
+    stage.lookahead = 0;
+    if (digit < 0) {
+      stage.exhausted = true;
+      return -1;
+    }
+
+    uint64_t count = 1;
+    int following;
+    while ((following = pull(level - 1)) == digit)
+      count++;
+    if (following < 0) stage.exhausted = true;
+    else stage.lookahead = following;
+
+    char reversed[20];
+    int length = 0;
+    while (count > 0) {
+      reversed[length++] = '0' + count % 10;
+      count /= 10;
+    }
+    stage.pending_len = 0;
+    while (length > 0)
+      stage.pending[stage.pending_len++] = reversed[--length];
+    stage.pending[stage.pending_len++] = digit;
+    stage.pending_pos = 1;
+    return stage.pending[0];
+  }
+
+  std::string seed;
+  size_t seed_pos;
+  std::vector<Stage> stages;
+};
+
+uint64_t streamLength(const std::string& seed, int n) {
+  LookAndSayStream stream(seed, n);
+  uint64_t length = 0;
+  while (stream.next() >= 0)
+    length++;
+  return length;
+}
+
+/*
+ * Writes up to `limit` digits (all of them when limit is 0) to `path` while
+ * counting the whole sequence into `length`, so it is generated only once.
+ * Returns false if the file can't be written.
+ */
+bool writeSequence(const std::string& seed, int n, const std::string& path,
+                   uint64_t limit, uint64_t& length) {
+  std::ofstream output(path, std::ios::binary);
+  if (!output.is_open()) return false;
+
+  LookAndSayStream stream(seed, n);
+  std::vector<char> buffer(1 << 16);
+  size_t used = 0;
+  int digit;
+  for (length = 0; (digit = stream.next()) >= 0; length++) {
+    if (limit != 0 && length >= limit) continue;
+    buffer[used++] = digit;
+    if (used == buffer.size()) {
+      if (!output.write(buffer.data(), used)) return false;
+      used = 0;
+    }
+  }
+  output.write(buffer.data(), used);
+  output.close();
+  return !output.fail();
+}
+
+void benchmark(const std::string& seed) {
+  bool saved_debug = debug;
+  debug = false;
+  for (int n : {50, 60}) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t string_length = lookAndSay(seed, n).size();
+    auto middle = std::chrono::steady_clock::now();
+    uint64_t stream_length = streamLength(seed, n);
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> string_time = middle - start;
+    std::chrono::duration<double> stream_time = end - middle;
+    std::cout << "n=" << n << " length=" << stream_length
+              << (string_length == stream_length ? "" : " (MISMATCH)")
+              << " string: " << string_time.count() << "s"
+              << " stream: " << stream_time.count() << "s" << std::endl;
+  }
+  debug = saved_debug;
+}
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  std::string output_path = (argc >= 3) ? argv[2] : "";
+  std::string digits = (argc >= 4) ? argv[3] : "0";
   checkDebugFlag(user_input, debug);
+  if (digits.empty() || digits.size() > 19 ||
+      !std::all_of(digits.begin(), digits.end(), ::isdigit)) {
+    std::cerr << "Error: The digit limit must be a number!" << std::endl;
+    return 1;
+  }
+  uint64_t digit_limit = std::stoull(digits);
 
   std::ifstream input_file(user_input);
   if (!input_file.is_open()) {
@@ -84,14 +222,28 @@ int main(int argc, char* argv[]) {
   stream >> input >> n;
 
   if (debug) std::cout << "input: " << input << " * " << n << std::endl;
-  std::string say = lookAndSay(input, n);
-
+  if (output_path == "bench") {
+    benchmark(input);
+    return 0;
+  }
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = say.size();
+  uint64_t total;
+  if (output_path.empty()) {
+    total = streamLength(input, n);
+  } else {
+    if (!writeSequence(input, n, output_path, digit_limit, total)) {
+      std::cerr << "Error writing " << output_path << "!" << std::endl;
+      return 1;
+    }
+    uint64_t written = (digit_limit == 0) ? total
+                                          : std::min(total, digit_limit);
+    std::cout << "WROTE " << written << " DIGITS TO " << output_path
+              << std::endl;
+  }
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
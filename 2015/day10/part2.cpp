@@ -20,6 +20,16 @@
  *   1211 → 111221 (one 1, one 2, two 1s)
  *   111221 → 312211 (three 1s, two 2s, one 1)
  *
+ * Instead of building the string, the seed is split into Conway's 92
+ * audioactive elements and only the count of each element is tracked. Every
+ * element decays into a fixed compound of elements, so one iteration is a
+ * product with the 92x92 decay matrix and n iterations are computed with
+ * square-and-multiply on that matrix. Seeds that are not yet a compound of
+ * elements are expanded naively until they split; a digit other than 1-3, or
+ * a run of four equal digits, never goes away, so such seeds are rejected. An
+ * optional second argument overrides the number of iterations (e.g. `part2
+ * input 1000`).
+ *
  * The program processes the initial sequence through 50 iterations and outputs
  * the length of the final result.
  *
@@ -28,10 +38,13 @@
  * @author [gabrielzschmitz]
  * @date [30/08/2024]
  */
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -44,10 +57,234 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-std::string lookAndSay(std::string input, int n) {
-  if (n == 0) return input;
+struct Element {
+  const char* name;
+  const char* sequence;
+  const char* decay;
+};
+
+const int ELEMENT_COUNT = 92;
+
+const Element ELEMENTS[ELEMENT_COUNT] = {
+  {"H", "22", "H"},
+  {"He", "13112221133211322112211213322112", "Hf.Pa.H.Ca.Li"},
+  {"Li", "312211322212221121123222112", "He"},
+  {"Be", "111312211312113221133211322112211213322112", "Ge.Ca.Li"},
+  {"B", "1321132122211322212221121123222112", "Be"},
+  {"C", "3113112211322112211213322112", "B"},
+  {"N", "111312212221121123222112", "C"},
+  {"O", "132112211213322112", "N"},
+  {"F", "31121123222112", "O"},
+  {"Ne", "111213322112", "F"},
+  {"Na", "123222112", "Ne"},
+  {"Mg", "3113322112", "Pm.Na"},
+  {"Al", "1113222112", "Mg"},
+  {"Si", "1322112", "Al"},
+  {"P", "311311222112", "Ho.Si"},
+  {"S", "1113122112", "P"},
+  {"Cl", "132112", "S"},
+  {"Ar", "3112", "Cl"},
+  {"K", "1112", "Ar"},
+  {"Ca", "12", "K"},
+  {"Sc", "3113112221133112", "Ho.Pa.H.Ca.Co"},
+  {"Ti", "11131221131112", "Sc"},
+  {"V", "13211312", "Ti"},
+  {"Cr", "31132", "V"},
+  {"Mn", "111311222112", "Cr.Si"},
+  {"Fe", "13122112", "Mn"},
+  {"Co", "32112", "Fe"},
+  {"Ni", "11133112", "Zn.Co"},
+  {"Cu", "131112", "Ni"},
+  {"Zn", "312", "Cu"},
+  {"Ga", "13221133122211332", "Eu.Ca.Ac.H.Ca.Zn"},
+  {"Ge", "31131122211311122113222", "Ho.Ga"},
+  {"As", "11131221131211322113322112", "Ge.Na"},
+  {"Se", "13211321222113222112", "As"},
+  {"Br", "3113112211322112", "Se"},
+  {"Kr", "11131221222112", "Br"},
+  {"Rb", "1321122112", "Kr"},
+  {"Sr", "3112112", "Rb"},
+  {"Y", "1112133", "Sr.U"},
+  {"Zr", "12322211331222113112211", "Y.H.Ca.Tc"},
+  {"Nb", "1113122113322113111221131221", "Er.Zr"},
+  {"Mo", "13211322211312113211", "Nb"},
+  {"Tc", "311322113212221", "Mo"},
+  {"Ru", "132211331222113112211", "Eu.Ca.Tc"},
+  {"Rh", "311311222113111221131221", "Ho.Ru"},
+  {"Pd", "111312211312113211", "Rh"},
+  {"Ag", "132113212221", "Pd"},
+  {"Cd", "3113112211", "Ag"},
+  {"In", "11131221", "Cd"},
+  {"Sn", "13211", "In"},
+  {"Sb", "3112221", "Pm.Sn"},
+  {"Te", "1322113312211", "Eu.Ca.Sb"},
+  {"I", "311311222113111221", "Ho.Te"},
+  {"Xe", "11131221131211", "I"},
+  {"Cs", "13211321", "Xe"},
+  {"Ba", "311311", "Cs"},
+  {"La", "11131", "Ba"},
+  {"Ce", "1321133112", "La.H.Ca.Co"},
+  {"Pr", "31131112", "Ce"},
+  {"Nd", "111312", "Pr"},
+  {"Pm", "132", "Nd"},
+  {"Sm", "311332", "Pm.Ca.Zn"},
+  {"Eu", "1113222", "Sm"},
+  {"Gd", "13221133112", "Eu.Ca.Co"},
+  {"Tb", "3113112221131112", "Ho.Gd"},
+  {"Dy", "111312211312", "Tb"},
+  {"Ho", "1321132", "Dy"},
+  {"Er", "311311222", "Ho.Pm"},
+  {"Tm", "11131221133112", "Er.Ca.Co"},
+  {"Yb", "1321131112", "Tm"},
+  {"Lu", "311312", "Yb"},
+  {"Hf", "11132", "Lu"},
+  {"Ta", "13112221133211322112211213322113", "Hf.Pa.H.Ca.W"},
+  {"W", "312211322212221121123222113", "Ta"},
+  {"Re", "111312211312113221133211322112211213322113", "Ge.Ca.W"},
+  {"Os", "1321132122211322212221121123222113", "Re"},
+  {"Ir", "3113112211322112211213322113", "Os"},
+  {"Pt", "111312212221121123222113", "Ir"},
+  {"Au", "132112211213322113", "Pt"},
+  {"Hg", "31121123222113", "Au"},
+  {"Tl", "111213322113", "Hg"},
+  {"Pb", "123222113", "Tl"},
+  {"Bi", "3113322113", "Pm.Pb"},
+  {"Po", "1113222113", "Bi"},
+  {"At", "1322113", "Po"},
+  {"Rn", "311311222113", "Ho.At"},
+  {"Fr", "1113122113", "Rn"},
+  {"Ra", "132113", "Fr"},
+  {"Ac", "3113", "Ra"},
+  {"Th", "1113", "Ac"},
+  {"Pa", "13", "Th"},
+  {"U", "3", "Pa"},
+};
+
+/* Unsigned integer of arbitrary size, stored as base 10^9 limbs. */
+struct BigCount {
+  static const uint32_t BASE = 1000000000;
+  std::vector<uint32_t> limbs;
+
+  BigCount(uint64_t value = 0) {
+    while (value > 0) {
+      limbs.push_back(value % BASE);
+      value /= BASE;
+    }
+  }
+
+  bool isZero() const { return limbs.empty(); }
 
-  std::string newStr = "";
+  BigCount& operator+=(const BigCount& other) {
+    if (limbs.size() < other.limbs.size()) limbs.resize(other.limbs.size(), 0);
+    uint32_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); i++) {
+      uint32_t sum = limbs[i] + carry;
+      if (i < other.limbs.size()) sum += other.limbs[i];
+      carry = sum >= BASE;
+      limbs[i] = carry ? sum - BASE : sum;
+      if (!carry && i >= other.limbs.size()) break;
+    }
+    if (carry) limbs.push_back(carry);
+    return *this;
+  }
+
+  /* Adds a * b in place, without allocating a temporary product. */
+  void addProduct(const BigCount& a, const BigCount& b) {
+    if (a.isZero() || b.isZero()) return;
+    size_t size = a.limbs.size() + b.limbs.size();
+    if (limbs.size() < size) limbs.resize(size, 0);
+    for (size_t i = 0; i < a.limbs.size(); i++) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < b.limbs.size(); j++) {
+        uint64_t cur = limbs[i + j] + (uint64_t)a.limbs[i] * b.limbs[j] + carry;
+        limbs[i + j] = cur % BASE;
+        carry = cur / BASE;
+      }
+      for (size_t k = i + b.limbs.size(); carry > 0; k++) {
+        if (k == limbs.size()) limbs.push_back(0);
+        uint64_t cur = limbs[k] + carry;
+        limbs[k] = cur % BASE;
+        carry = cur / BASE;
+      }
+    }
+    while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+  }
+
+  std::string toString() const {
+    if (isZero()) return "0";
+    std::string out = std::to_string(limbs.back());
+    for (int i = (int)limbs.size() - 2; i >= 0; i--) {
+      std::string part = std::to_string(limbs[i]);
+      out += std::string(9 - part.size(), '0') + part;
+    }
+    return out;
+  }
+};
+
+typedef std::vector<BigCount> Matrix;
+typedef std::vector<BigCount> CountVector;
+
+std::vector<std::vector<int>> decays;
+std::vector<int> first_decay;
+
+int findElement(const std::string& name) {
+  for (int i = 0; i < ELEMENT_COUNT; i++)
+    if (name == ELEMENTS[i].name) return i;
+  return -1;
+}
+
+void buildDecayTable() {
+  decays.assign(ELEMENT_COUNT, {});
+  first_decay.assign(ELEMENT_COUNT, 0);
+  for (int i = 0; i < ELEMENT_COUNT; i++) {
+    std::istringstream stream(ELEMENTS[i].decay);
+    std::string name;
+    while (std::getline(stream, name, '.'))
+      decays[i].push_back(findElement(name));
+    first_decay[i] = decays[i].front();
+  }
+}
+
+/*
+ * A boundary between a digit and an element never interacts as long as the
+ * leading digit of every descendant of the element differs from it. The last
+ * digit of the left side never changes, and the chain of leading elements
+ * cycles within ELEMENT_COUNT steps, so checking twice that many is exact.
+ */
+bool canSplit(char left_digit, int right_element) {
+  int element = right_element;
+  for (int step = 0; step < 2 * ELEMENT_COUNT; step++) {
+    if (ELEMENTS[element].sequence[0] == left_digit) return false;
+    element = first_decay[element];
+  }
+  return true;
+}
+
+/* Splits the seed into elements, returning false if it is not a compound. */
+bool splitIntoElements(const std::string& seed, std::vector<int>& out) {
+  int length = seed.size();
+  std::vector<int> previous(length + 1, -2), chosen(length + 1, -1);
+  previous[0] = -1;
+  for (int pos = 0; pos < length; pos++) {
+    if (previous[pos] == -2) continue;
+    for (int e = 0; e < ELEMENT_COUNT; e++) {
+      int size = strlen(ELEMENTS[e].sequence);
+      if (pos + size > length || previous[pos + size] != -2) continue;
+      if (seed.compare(pos, size, ELEMENTS[e].sequence) != 0) continue;
+      if (pos > 0 && !canSplit(seed[pos - 1], e)) continue;
+      previous[pos + size] = pos;
+      chosen[pos + size] = e;
+    }
+  }
+  if (previous[length] == -2) return false;
+  out.clear();
+  for (int pos = length; pos > 0; pos = previous[pos])
+    out.insert(out.begin(), chosen[pos]);
+  return true;
+}
+
+std::string lookAndSayStep(const std::string& input) {
+  std::string newStr;
   int length = input.size();
   int i = 0;
 
@@ -57,17 +294,100 @@ std::string lookAndSay(std::string input, int n) {
       i++;
       count++;
     }
-    newStr += std::to_string(count) + input[i];
-    if (debug)
-      std::cout << "current: " << std::to_string(count) + input[i] << std::endl;
+    newStr += std::to_string(count);
+    newStr += input[i];
     i++;
   }
 
-  return lookAndSay(newStr, n - 1);
+  return newStr;
+}
+
+Matrix decayMatrix() {
+  Matrix matrix(ELEMENT_COUNT * ELEMENT_COUNT);
+  for (int from = 0; from < ELEMENT_COUNT; from++)
+    for (int to : decays[from]) matrix[from * ELEMENT_COUNT + to] += 1;
+  return matrix;
+}
+
+Matrix multiplyMatrices(const Matrix& a, const Matrix& b) {
+  Matrix result(ELEMENT_COUNT * ELEMENT_COUNT);
+  for (int i = 0; i < ELEMENT_COUNT; i++)
+    for (int k = 0; k < ELEMENT_COUNT; k++) {
+      const BigCount& left = a[i * ELEMENT_COUNT + k];
+      if (left.isZero()) continue;
+      for (int j = 0; j < ELEMENT_COUNT; j++) {
+        const BigCount& right = b[k * ELEMENT_COUNT + j];
+        if (right.isZero()) continue;
+        result[i * ELEMENT_COUNT + j].addProduct(left, right);
+      }
+    }
+  return result;
+}
+
+CountVector applyMatrix(const CountVector& counts, const Matrix& matrix) {
+  CountVector result(ELEMENT_COUNT);
+  for (int from = 0; from < ELEMENT_COUNT; from++) {
+    if (counts[from].isZero()) continue;
+    for (int to = 0; to < ELEMENT_COUNT; to++)
+      result[to].addProduct(counts[from], matrix[from * ELEMENT_COUNT + to]);
+  }
+  return result;
+}
+
+/* Advances the element counts n iterations by square-and-multiply. */
+CountVector advance(CountVector counts, long long n) {
+  Matrix power = decayMatrix();
+  while (n > 0) {
+    if (n & 1) counts = applyMatrix(counts, power);
+    n >>= 1;
+    if (n > 0) power = multiplyMatrices(power, power);
+  }
+  return counts;
+}
+
+/*
+ * A digit above 3 never goes away, and a run of four or more equal digits
+ * becomes one after a step, so such seeds never split into the common
+ * elements. Every other seed eventually does.
+ */
+bool splitsEventually(const std::string& seed) {
+  if (seed.empty()) return false;
+  size_t run = 0;
+  for (size_t i = 0; i < seed.size(); i++) {
+    if (seed[i] < '1' || seed[i] > '3') return false;
+    run = (i > 0 && seed[i] == seed[i - 1]) ? run + 1 : 1;
+    if (run >= 4) return false;
+  }
+  return true;
+}
+
+BigCount lookAndSayLength(std::string seed, long long n) {
+  std::vector<int> elements;
+  while (!splitIntoElements(seed, elements)) {
+    if (n == 0) return BigCount(seed.size());
+    seed = lookAndSayStep(seed);
+    n--;
+  }
+
+  CountVector counts(ELEMENT_COUNT);
+  for (int e : elements) counts[e] += 1;
+  if (debug) {
+    std::cout << "elements:";
+    for (int e : elements) std::cout << " " << ELEMENTS[e].name;
+    std::cout << " (" << n << " iterations left)" << std::endl;
+  }
+
+  counts = advance(counts, n);
+
+  BigCount length;
+  for (int e = 0; e < ELEMENT_COUNT; e++)
+    length.addProduct(counts[e], BigCount(strlen(ELEMENTS[e].sequence)));
+  return length;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  long long iterations = (argc >= 3) ? std::stoll(argv[2]) : 50;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -83,15 +403,22 @@ int main(int argc, char* argv[]) {
   std::istringstream stream(line);
   stream >> input >> _;
 
-  if (debug) std::cout << "input: " << input << " * " << _ << std::endl;
-  std::string say = lookAndSay(input, 50);
+  if (!splitsEventually(input)) {
+    std::cerr << "Error: Seeds need the digits 1-3 in runs shorter than 4 "
+              << "to split into the common elements!" << std::endl;
+    return 1;
+  }
+
+  if (debug)
+    std::cout << "input: " << input << " * " << iterations << std::endl;
+  buildDecayTable();
+  BigCount total = lookAndSayLength(input, iterations);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = say.size();
-  std::cout << "ANSWER: " << total << std::endl;
+  std::cout << "ANSWER: " << total.toString() << std::endl;
   return 0;
 }
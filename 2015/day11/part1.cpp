@@ -24,14 +24,24 @@
  * The program processes the current password and outputs the next valid
  * password according to the rules.
  *
+ * Valid passwords are built directly: the rightmost letter that can be raised
+ * is raised and the smallest suffix satisfying the rules is filled in after
+ * it, skipping past any forbidden letter in one step.
+ * - `part1 input <count>` prints the next <count> valid passwords.
+ * - `part1 input bench` times this against the increment-and-test loop.
+ *
  * Puzzle Answer: [Next Valid Password]
  *
  * @author [gabrielzschmitz]
  * @date [31/08/2024]
  */
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -85,8 +95,141 @@ bool isValidPassword(const std::string& password) {
          hasTwoNonOverlappingPairs(password);
 }
 
+const int PASSWORD_LENGTH = 8;
+
+typedef std::array<char, PASSWORD_LENGTH> Password;
+
+bool isForbidden(char letter) {
+  return letter == 'i' || letter == 'o' || letter == 'l';
+}
+
+/* What the rules need to know about a password prefix. */
+struct RuleState {
+  char last = 0;
+  int run = 0;              // length of the straight ending at `last`
+  bool straight = false;
+  int pairs = 0;            // counted greedily left to right
+  bool last_paired = true;  // `last` already used by a pair (or no letter)
+};
+
+RuleState extend(RuleState state, char letter) {
+  state.run = (state.last != 0 && letter == state.last + 1) ? state.run + 1 : 1;
+  state.straight |= state.run >= 3;
+  if (!state.last_paired && letter == state.last) {
+    state.pairs++;
+    state.last_paired = true;
+  } else {
+    state.last_paired = false;
+  }
+  state.last = letter;
+  return state;
+}
+
+/* A lower bound on how many more letters the rules still need. */
+int lettersNeeded(const RuleState& state) {
+  int straight = state.straight ? 0 : 3 - std::min(state.run, 2);
+  int pairs = 2 * std::max(0, 2 - state.pairs);
+  if (pairs > 0 && !state.last_paired) pairs--;
+  return std::max(straight, pairs);
+}
+
+/*
+ * Fills password[position..] with the smallest letters that make the whole
+ * password valid, or returns false if no suffix can.
+ */
+bool completeSmallest(Password& password, int position,
+                      const RuleState& state) {
+  if (position == PASSWORD_LENGTH) return state.straight && state.pairs >= 2;
+  if (lettersNeeded(state) > PASSWORD_LENGTH - position) return false;
+  for (char letter = 'a'; letter <= 'z'; letter++) {
+    if (isForbidden(letter)) continue;
+    password[position] = letter;
+    if (completeSmallest(password, position + 1, extend(state, letter)))
+      return true;
+  }
+  return false;
+}
+
+/*
+ * Moves to the next valid password. Rather than testing every increment, it
+ * finds the rightmost position that can be raised and builds the smallest
+ * valid suffix after it. A forbidden letter caps that position, so everything
+ * past it is replaced in one step.
+ */
+void nextValidPassword(Password& password) {
+  int end = 0;
+  std::array<RuleState, PASSWORD_LENGTH + 1> prefix;
+  while (end < PASSWORD_LENGTH - 1 && !isForbidden(password[end])) {
+    prefix[end + 1] = extend(prefix[end], password[end]);
+    end++;
+  }
+
+  for (int position = end; position >= 0; position--)
+    for (char letter = password[position] + 1; letter <= 'z'; letter++) {
+      if (isForbidden(letter)) continue;
+      Password candidate = password;
+      candidate[position] = letter;
+      if (completeSmallest(candidate, position + 1,
+                           extend(prefix[position], letter))) {
+        password = candidate;
+        return;
+      }
+    }
+
+  // Past "zzzzzzzz" counting wraps around to "aaaaaaaa".
+  completeSmallest(password, 0, RuleState());
+}
+
+/* Yields the valid passwords after a starting one, in order. */
+class PasswordSequence {
+ public:
+  explicit PasswordSequence(const Password& start) : current(start) {}
+
+  const Password& next() {
+    nextValidPassword(current);
+    return current;
+  }
+
+  /* The next `count` valid passwords. */
+  std::vector<Password> take(size_t count) {
+    std::vector<Password> passwords;
+    for (size_t i = 0; i < count; i++)
+      passwords.push_back(next());
+    return passwords;
+  }
+
+ private:
+  Password current;
+};
+
+std::string toString(const Password& password) {
+  return std::string(password.begin(), password.end());
+}
+
+void benchmark(const Password& start) {
+  for (size_t count : {10, 100, 1000}) {
+    auto begin = std::chrono::steady_clock::now();
+    std::string naive = toString(start);
+    for (size_t i = 0; i < count; i++)
+      do {
+        naive = incrementPassword(naive);
+      } while (!isValidPassword(naive));
+    auto middle = std::chrono::steady_clock::now();
+    Password fast = PasswordSequence(start).take(count).back();
+    auto end = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> naive_time = middle - begin;
+    std::chrono::duration<double> fast_time = end - middle;
+    std::cout << "count=" << count << " last=" << toString(fast)
+              << (naive == toString(fast) ? "" : " (MISMATCH)")
+              << " naive: " << naive_time.count() << "s"
+              << " structural: " << fast_time.count() << "s" << std::endl;
+  }
+}
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  std::string mode = (argc >= 3) ? argv[2] : "";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -95,19 +238,33 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::string password;
-  std::getline(input_file, password);
-
-  do {
-    password = incrementPassword(password);
-  } while (!isValidPassword(password));
+  std::string line;
+  std::getline(input_file, line);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
+  if (line.size() != PASSWORD_LENGTH) {
+    std::cerr << "Error: Passwords have " << PASSWORD_LENGTH << " letters!"
+              << std::endl;
+    return 1;
+  }
+
+  Password start;
+  std::copy(line.begin(), line.end(), start.begin());
+  if (mode == "bench") {
+    benchmark(start);
+    return 0;
+  }
+
+  size_t count = mode.empty() ? 1 : std::stoul(mode);
+  std::vector<Password> passwords = PasswordSequence(start).take(count);
+  if (debug || count != 1)
+    for (const Password& password : passwords)
+      std::cout << toString(password) << std::endl;
 
-  std::string total = password;
+  std::string total = toString(passwords.back());
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -30,13 +30,28 @@
  * The program processes the input JSON document, applies the "red" filter, and
  * outputs the sum of all valid numbers.
  *
+ * The document is memory mapped and scanned in two stages: a vectorized pass
+ * indexes the structural characters outside strings, and a second pass walks
+ * only those positions to sum numbers and drop red objects. `part2 input
+ * bench` reports the throughput of both this and the original state machine.
+ *
  * Puzzle Answer: [Filtered Sum of All Numbers]
  *
  * @author [gabrielzschmitz]
  * @date [01/09/2024]
  */
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -171,26 +186,288 @@ void solve(std::istream& is, int& total) {
   total = std::get<bool>(objs.back()) ? 0 : std::get<int>(objs.back());
 }
 
+/* Read-only memory map of a whole file. */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) : bytes(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+      if (info.st_size > 0) {
+        void* mapped =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          bytes = static_cast<const char*>(mapped);
+          length = info.st_size;
+        }
+      }
+      // An empty file is open with nothing mapped; a failed mapping is not.
+      opened = info.st_size == 0 || bytes != nullptr;
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool isOpen() const { return opened; }
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+ private:
+  const char* bytes;
+  size_t length;
+  bool opened = false;
+};
+
+const size_t INDEX_WINDOW = 1 << 16;
+
+/* One bit per byte of a 64-byte block for each character class. */
+struct BlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t operators;  // { } [ ] : ,
+  uint64_t numeric;    // digits and '-'
+};
+
+BlockMasks classifyBlockScalar(const char* block) {
+  BlockMasks masks = {0, 0, 0, 0};
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = 1ULL << i;
+    switch (block[i]) {
+      case '"': masks.quote |= bit; break;
+      case '\\': masks.backslash |= bit; break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',': masks.operators |= bit; break;
+      case '-': masks.numeric |= bit; break;
+      default:
+        if ('0' <= block[i] && block[i] <= '9') masks.numeric |= bit;
+        break;
+    }
+  }
+  return masks;
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline uint32_t bytesEqual(__m256i bytes, char ch) {
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(ch)));
+}
+
+/* Builds the same masks from 32-byte compares. Needs AVX2. */
+AVX2_TARGET BlockMasks classifyBlockAvx2(const char* block) {
+  BlockMasks masks = {0, 0, 0, 0};
+  for (int half = 0; half < 2; half++) {
+    __m256i bytes =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * half));
+    __m256i digit = _mm256_sub_epi8(bytes, _mm256_set1_epi8('0'));
+    uint32_t is_digit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+      _mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit));
+    uint32_t operators = bytesEqual(bytes, '{') | bytesEqual(bytes, '}') |
+                         bytesEqual(bytes, '[') | bytesEqual(bytes, ']') |
+                         bytesEqual(bytes, ':') | bytesEqual(bytes, ',');
+    int shift = 32 * half;
+    masks.quote |= (uint64_t)bytesEqual(bytes, '"') << shift;
+    masks.backslash |= (uint64_t)bytesEqual(bytes, '\\') << shift;
+    masks.operators |= (uint64_t)operators << shift;
+    masks.numeric |= (uint64_t)(is_digit | bytesEqual(bytes, '-')) << shift;
+  }
+  return masks;
+}
+
+uint64_t prefixXorScalar(uint64_t bits) {
+  for (int shift = 1; shift < 64; shift <<= 1)
+    bits ^= bits << shift;
+  return bits;
+}
+
+/* Carry-less multiplication by all ones is a prefix XOR. Needs PCLMUL. */
+__attribute__((target("pclmul"))) uint64_t prefixXorClmul(uint64_t bits) {
+  __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, bits),
+                                         _mm_set1_epi8(-1), 0);
+  return _mm_cvtsi128_si64(product);
+}
+
+/*
+ * Stage 1: finds the positions stage 2 has to look at, 64 bytes at a time.
+ * Quotes that are not escaped toggle the in-string mask (a prefix XOR), and
+ * outside strings the operators, opening quotes and first characters of
+ * numbers are kept. Escape, string and number state carry across blocks.
+ */
+class StructuralIndexer {
+ public:
+  StructuralIndexer(const char* data, size_t size) : data(data), size(size) {
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool pclmul = __builtin_cpu_supports("pclmul");
+    classifyBlock = avx2 ? classifyBlockAvx2 : classifyBlockScalar;
+    prefixXor = pclmul ? prefixXorClmul : prefixXorScalar;
+  }
+
+  /*
+   * Fills the first `count` positions with the structural positions of the
+   * next window; returns false once the document is exhausted.
+   */
+  bool nextWindow(std::vector<size_t>& positions, size_t& count) {
+    if (offset >= size) return false;
+    positions.resize(INDEX_WINDOW + 64);
+    count = 0;
+    size_t window_end = std::min(size, offset + INDEX_WINDOW);
+    char padded[64];
+    for (; offset < window_end; offset += 64) {
+      const char* block = data + offset;
+      if (size - offset < 64) {
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, block, size - offset);
+        block = padded;
+      }
+      uint64_t bits = indexBlock(classifyBlock(block));
+      // Writes four positions per step whether or not they exist, which
+      // avoids a hard-to-predict branch per bit; the extras are overwritten.
+      size_t found = __builtin_popcountll(bits);
+      for (size_t i = 0; i < found; i += 4)
+        for (int j = 0; j < 4; j++) {
+          positions[count + i + j] =
+            offset + __builtin_ctzll(bits | 1ULL << 63);
+          bits &= bits - 1;
+        }
+      count += found;
+    }
+    return true;
+  }
+
+ private:
+  const char* data;
+  size_t size;
+  size_t offset = 0;
+  uint64_t next_is_escaped = 0;
+  uint64_t in_string = 0;
+  uint64_t in_number = 0;
+  BlockMasks (*classifyBlock)(const char*);
+  uint64_t (*prefixXor)(uint64_t);
+
+  uint64_t indexBlock(const BlockMasks& masks) {
+    const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    uint64_t backslash = masks.backslash & ~next_is_escaped;
+    uint64_t follows_escape = (backslash << 1) | next_is_escaped;
+    uint64_t odd_starts = backslash & ~EVEN_BITS & ~follows_escape;
+    unsigned long long even_runs;
+    next_is_escaped =
+      __builtin_uaddll_overflow(odd_starts, backslash, &even_runs);
+    uint64_t escaped = (EVEN_BITS ^ (even_runs << 1)) & follows_escape;
+
+    uint64_t quotes = masks.quote & ~escaped;
+    uint64_t strings = prefixXor(quotes) ^ in_string;
+    in_string = -(strings >> 63);
+
+    uint64_t numeric = masks.numeric & ~strings;
+    uint64_t number_starts = numeric & ~((numeric << 1) | in_number);
+    in_number = numeric >> 63;
+
+    return (masks.operators & ~strings) | (quotes & strings) | number_starts;
+  }
+};
+
+/*
+ * Stage 2: walks only the structural positions. Each open object keeps its
+ * running sum and whether it has a "red" value; closing one adds its sum to
+ * the enclosing object unless it was red. Arrays need no state of their own.
+ */
+bool sumNonRed(const char* data, size_t size, int64_t& total) {
+  struct Frame {
+    int64_t sum;
+    bool red;
+  };
+  std::vector<Frame> frames = {{0, false}};
+  std::vector<size_t> positions;
+  StructuralIndexer indexer(data, size);
+  size_t count;
+  bool after_colon = false;
+
+  while (indexer.nextWindow(positions, count))
+    for (size_t i = 0; i < count; i++) {
+      size_t position = positions[i];
+      char ch = data[position];
+      switch (ch) {
+        case '{': frames.push_back({0, false}); break;
+        case '}': {
+          if (frames.size() == 1) return false;
+          Frame closed = frames.back();
+          frames.pop_back();
+          if (!closed.red) frames.back().sum += closed.sum;
+          break;
+        }
+        case '"':
+          if (after_colon && size - position >= 5 &&
+              std::memcmp(data + position, "\"red\"", 5) == 0)
+            frames.back().red = true;
+          break;
+        default:
+          if (ch == '-' || ('0' <= ch && ch <= '9')) {
+            bool negative = (ch == '-');
+            int64_t value = 0;
+            for (size_t i = position + negative;
+                 i < size && '0' <= data[i] && data[i] <= '9'; i++)
+              value = value * 10 + (data[i] - '0');
+            frames.back().sum += negative ? -value : value;
+          }
+          break;
+      }
+      after_colon = (ch == ':');
+    }
+
+  if (frames.size() != 1) return false;
+  total = frames.back().red ? 0 : frames.back().sum;
+  return true;
+}
+
+/* Times the state machine against the two-stage scanner on the same file. */
+void benchmark(const std::string& path, const MappedFile& mapped) {
+  double gigabytes = mapped.size() / 1e9;
+
+  auto begin = std::chrono::steady_clock::now();
+  std::ifstream input_file(path);
+  int machine_total = 0;
+  solve(input_file, machine_total);
+  auto middle = std::chrono::steady_clock::now();
+  int64_t scanner_total = 0;
+  sumNonRed(mapped.data(), mapped.size(), scanner_total);
+  auto end = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> machine_time = middle - begin;
+  std::chrono::duration<double> scanner_time = end - middle;
+  std::cout << "solve(): " << machine_total << " in " << machine_time.count()
+            << "s (" << gigabytes / machine_time.count() << " GB/s)\n"
+            << "two-stage: " << scanner_total << " in "
+            << scanner_time.count() << "s ("
+            << gigabytes / scanner_time.count() << " GB/s)" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  bool bench = (argc >= 3) && std::string(argv[2]) == "bench";
   checkDebugFlag(user_input, debug);
 
-  std::ifstream input_file(user_input);
-  if (!input_file.is_open()) {
+  MappedFile input_file(user_input);
+  if (!input_file.isOpen()) {
     std::cerr << "FILE " << user_input << " UNAVAILABLE!" << std::endl;
     return 1;
   }
 
-  int total = 0;
-  try {
-    solve(input_file, total);
-  } catch (...) {
-    std::cerr << "Error processing the JSON file" << std::endl;
-    return 1;
+  if (bench) {
+    benchmark(user_input, input_file);
+    return 0;
   }
 
-  if (input_file.bad()) {
-    std::cerr << "Error reading the file!" << std::endl;
+  int64_t total = 0;
+  if (!sumNonRed(input_file.data(), input_file.size(), total)) {
+    std::cerr << "Error processing the JSON file" << std::endl;
     return 1;
   }
 
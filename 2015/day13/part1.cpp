@@ -13,8 +13,9 @@
  * neighbors.
  *
  * The task is to calculate the optimal seating arrangement that yields the
- * maximum possible change in happiness. The program explores all possible
- * seating arrangements and selects the one that maximizes total happiness.
+ * maximum possible change in happiness. The pairwise happiness is folded into a
+ * symmetric matrix and the best cycle is found with Held-Karp dynamic
+ * programming over subsets of guests, with the first guest fixed in place.
  *
  * Example Input:
  * - Alice would gain 54 happiness units by sitting next to Bob.
@@ -38,12 +39,13 @@
  */
 #include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -64,6 +66,79 @@ std::vector<std::string> splitString(const std::string& s, char delimiter) {
   return tokens;
 }
 
+/* Splits [0, count) across the available cores and waits for all of them. */
+template <typename Function>
+void parallelFor(size_t count, Function function) {
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  if (count < 4096 || workers == 1) {
+    function(0, count);
+    return;
+  }
+  workers = std::min(workers, count);
+  std::vector<std::thread> threads;
+  size_t chunk = (count + workers - 1) / workers;
+  for (size_t begin = 0; begin < count; begin += chunk)
+    threads.emplace_back(function, begin, std::min(count, begin + chunk));
+  for (auto& thread : threads)
+    thread.join();
+}
+
+/* Removes bit `bit` from `mask`, shifting the higher bits down by one. */
+inline uint32_t dropBit(uint32_t mask, int bit) {
+  return ((mask >> (bit + 1)) << bit) | (mask & ((1u << bit) - 1));
+}
+
+/*
+ * Held-Karp over the circular table. Guest 0 is fixed to break the rotational
+ * symmetry; best[(rest, last)] is the best path that leaves guest 0, visits
+ * every guest in `rest` and ends at `last` (which is not part of `rest`).
+ * Subsets of the same size only depend on the previous size, so each layer is
+ * filled in parallel.
+ */
+int maxHappiness(const std::vector<int>& weight, int guests) {
+  if (guests < 2) return 0;
+  int others = guests - 1;
+  auto w = [&](int a, int b) { return weight[a * guests + b]; };
+
+  size_t rest_states = size_t(1) << (others - 1);
+  std::vector<int> best(rest_states * others);
+  auto at = [&](uint32_t rest, int last) -> int& {
+    return best[dropBit(rest, last) * others + last];
+  };
+
+  uint32_t full = (1u << others) - 1;
+  std::vector<std::vector<uint32_t>> layers(others);
+  for (uint32_t mask = 0; mask < full; mask++)
+    layers[__builtin_popcount(mask)].push_back(mask);
+
+  for (int last = 0; last < others; last++)
+    at(0, last) = w(0, last + 1);
+
+  for (int size = 1; size < others; size++) {
+    const std::vector<uint32_t>& layer = layers[size];
+    parallelFor(layer.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        uint32_t rest = layer[i];
+        for (int last = 0; last < others; last++) {
+          if (rest & (1u << last)) continue;
+          int result = INT_MIN;
+          for (uint32_t bits = rest; bits; bits &= bits - 1) {
+            int prev = __builtin_ctz(bits);
+            int value = at(rest & ~(1u << prev), prev) + w(prev + 1, last + 1);
+            result = std::max(result, value);
+          }
+          at(rest, last) = result;
+        }
+      }
+    });
+  }
+
+  int result = INT_MIN;
+  for (int last = 0; last < others; last++)
+    result = std::max(result, at(full & ~(1u << last), last) + w(last + 1, 0));
+  return result;
+}
+
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
@@ -74,9 +149,12 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::map<std::pair<std::string, std::string>, int> happiness_map;
-  std::set<std::string> attendees;
+  std::map<std::string, int> attendees;
+  std::vector<std::pair<std::pair<int, int>, int>> rules;
   std::string line;
+  auto guestIndex = [&](const std::string& name) {
+    return attendees.emplace(name, attendees.size()).first->second;
+  };
 
   while (std::getline(input_file, line)) {
     auto tokens = splitString(line, ' ');
@@ -84,24 +162,18 @@ int main(int argc, char* argv[]) {
     std::string name2 = tokens[10].substr(0, tokens[10].length() - 1);
     int happiness = std::stoi(tokens[3]);
     if (tokens[2] == "lose") happiness = -happiness;
-    happiness_map[{name1, name2}] = happiness;
-    attendees.insert(name1);
+    rules.push_back({{guestIndex(name1), guestIndex(name2)}, happiness});
+  }
+
+  int guests = attendees.size();
+  std::vector<int> weight(guests * guests, 0);
+  for (const auto& rule : rules) {
+    weight[rule.first.first * guests + rule.first.second] += rule.second;
+    weight[rule.first.second * guests + rule.first.first] += rule.second;
   }
+  if (debug) std::cout << "guests: " << guests << std::endl;
 
-  std::vector<std::string> attendees_vector(attendees.begin(), attendees.end());
-  int max_happiness = INT_MIN;
-
-  do {
-    int current_happiness = 0;
-    for (size_t i = 0; i < attendees_vector.size(); ++i) {
-      std::string left = attendees_vector[i];
-      std::string right = attendees_vector[(i + 1) % attendees_vector.size()];
-      current_happiness += happiness_map[{left, right}];
-      current_happiness += happiness_map[{right, left}];
-    }
-    if (current_happiness > max_happiness) max_happiness = current_happiness;
-  } while (
-    std::next_permutation(attendees_vector.begin(), attendees_vector.end()));
+  int max_happiness = maxHappiness(weight, guests);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
@@ -15,7 +15,8 @@
  * The task is to add the user to the guest list and assign a happiness score of
  * 0 to all relationships involving the user. Then, the program recalculates the
  * optimal seating arrangement to include the user and determines the total
- * change in happiness for this arrangement.
+ * change in happiness for this arrangement. As in part 1, the seating is
+ * solved with Held-Karp dynamic programming instead of trying permutations.
  *
  * Example:
  * - If the original optimal arrangement had a total happiness of 330, adding
@@ -29,12 +30,13 @@
  */
 #include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <map>
-#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -55,6 +57,79 @@ std::vector<std::string> splitString(const std::string& s, char delimiter) {
   return tokens;
 }
 
+/* Splits [0, count) across the available cores and waits for all of them. */
+template <typename Function>
+void parallelFor(size_t count, Function function) {
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  if (count < 4096 || workers == 1) {
+    function(0, count);
+    return;
+  }
+  workers = std::min(workers, count);
+  std::vector<std::thread> threads;
+  size_t chunk = (count + workers - 1) / workers;
+  for (size_t begin = 0; begin < count; begin += chunk)
+    threads.emplace_back(function, begin, std::min(count, begin + chunk));
+  for (auto& thread : threads)
+    thread.join();
+}
+
+/* Removes bit `bit` from `mask`, shifting the higher bits down by one. */
+inline uint32_t dropBit(uint32_t mask, int bit) {
+  return ((mask >> (bit + 1)) << bit) | (mask & ((1u << bit) - 1));
+}
+
+/*
+ * Held-Karp over the circular table. Guest 0 is fixed to break the rotational
+ * symmetry; best[(rest, last)] is the best path that leaves guest 0, visits
+ * every guest in `rest` and ends at `last` (which is not part of `rest`).
+ * Subsets of the same size only depend on the previous size, so each layer is
+ * filled in parallel.
+ */
+int maxHappiness(const std::vector<int>& weight, int guests) {
+  if (guests < 2) return 0;
+  int others = guests - 1;
+  auto w = [&](int a, int b) { return weight[a * guests + b]; };
+
+  size_t rest_states = size_t(1) << (others - 1);
+  std::vector<int> best(rest_states * others);
+  auto at = [&](uint32_t rest, int last) -> int& {
+    return best[dropBit(rest, last) * others + last];
+  };
+
+  uint32_t full = (1u << others) - 1;
+  std::vector<std::vector<uint32_t>> layers(others);
+  for (uint32_t mask = 0; mask < full; mask++)
+    layers[__builtin_popcount(mask)].push_back(mask);
+
+  for (int last = 0; last < others; last++)
+    at(0, last) = w(0, last + 1);
+
+  for (int size = 1; size < others; size++) {
+    const std::vector<uint32_t>& layer = layers[size];
+    parallelFor(layer.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        uint32_t rest = layer[i];
+        for (int last = 0; last < others; last++) {
+          if (rest & (1u << last)) continue;
+          int result = INT_MIN;
+          for (uint32_t bits = rest; bits; bits &= bits - 1) {
+            int prev = __builtin_ctz(bits);
+            int value = at(rest & ~(1u << prev), prev) + w(prev + 1, last + 1);
+            result = std::max(result, value);
+          }
+          at(rest, last) = result;
+        }
+      }
+    });
+  }
+
+  int result = INT_MIN;
+  for (int last = 0; last < others; last++)
+    result = std::max(result, at(full & ~(1u << last), last) + w(last + 1, 0));
+  return result;
+}
+
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
@@ -65,9 +140,12 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::map<std::pair<std::string, std::string>, int> happiness_map;
-  std::set<std::string> attendees;
+  std::map<std::string, int> attendees;
+  std::vector<std::pair<std::pair<int, int>, int>> rules;
   std::string line;
+  auto guestIndex = [&](const std::string& name) {
+    return attendees.emplace(name, attendees.size()).first->second;
+  };
 
   const std::string self = "gabrielzschmitz";
 
@@ -77,28 +155,19 @@ int main(int argc, char* argv[]) {
     std::string name2 = tokens[10].substr(0, tokens[10].length() - 1);
     int happiness = std::stoi(tokens[3]);
     if (tokens[2] == "lose") happiness = -happiness;
-    happiness_map[{name1, name2}] = happiness;
-    attendees.insert(name1);
+    rules.push_back({{guestIndex(name1), guestIndex(name2)}, happiness});
+  }
+  guestIndex(self);
 
-    happiness_map[{name1, self}] = 0;
-    happiness_map[{self, name1}] = 0;
+  int guests = attendees.size();
+  std::vector<int> weight(guests * guests, 0);
+  for (const auto& rule : rules) {
+    weight[rule.first.first * guests + rule.first.second] += rule.second;
+    weight[rule.first.second * guests + rule.first.first] += rule.second;
   }
-  attendees.insert(self);
-
-  std::vector<std::string> attendees_vector(attendees.begin(), attendees.end());
-  int max_happiness = INT_MIN;
-
-  do {
-    int current_happiness = 0;
-    for (size_t i = 0; i < attendees_vector.size(); ++i) {
-      std::string left = attendees_vector[i];
-      std::string right = attendees_vector[(i + 1) % attendees_vector.size()];
-      current_happiness += happiness_map[{left, right}];
-      current_happiness += happiness_map[{right, left}];
-    }
-    if (current_happiness > max_happiness) max_happiness = current_happiness;
-  } while (
-    std::next_permutation(attendees_vector.begin(), attendees_vector.end()));
+  if (debug) std::cout << "guests: " << guests << std::endl;
+
+  int max_happiness = maxHappiness(weight, guests);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
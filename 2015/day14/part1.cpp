@@ -30,6 +30,7 @@
  * @date [03/09/2024]
  */
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <ostream>
@@ -71,17 +72,17 @@ std::tuple<int, int, int> parseInput(std::string input) {
   return current;
 }
 
-int getReindeerDistance(const std::tuple<int, int, int>& reindeer,
-                        int total_time) {
-  int speed = std::get<0>(reindeer);
-  int fly_time = std::get<1>(reindeer);
-  int rest_time = std::get<2>(reindeer);
+int64_t getReindeerDistance(const std::tuple<int, int, int>& reindeer,
+                            int64_t total_time) {
+  int64_t speed = std::get<0>(reindeer);
+  int64_t fly_time = std::get<1>(reindeer);
+  int64_t rest_time = std::get<2>(reindeer);
 
-  int cycle_time = fly_time + rest_time;
-  int full_cycles = total_time / cycle_time;
-  int remaining_time = total_time % cycle_time;
+  int64_t cycle_time = fly_time + rest_time;
+  int64_t full_cycles = total_time / cycle_time;
+  int64_t remaining_time = total_time % cycle_time;
 
-  int distance = full_cycles * (speed * fly_time);
+  int64_t distance = full_cycles * (speed * fly_time);
   if (remaining_time >= fly_time) distance += speed * fly_time;
   else distance += speed * remaining_time;
 
@@ -89,7 +90,8 @@ int getReindeerDistance(const std::tuple<int, int, int>& reindeer,
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int64_t race_time = (argc >= 3) ? std::stoll(argv[2]) : 2503;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -109,16 +111,17 @@ int main(int argc, char* argv[]) {
       std::cout << std::get<0>(reindeer) << "km/s " << std::get<1>(reindeer)
                 << "s " << std::get<2>(reindeer) << "s" << std::endl;
 
-  int max_distance = 0;
+  int64_t max_distance = 0;
   for (const auto& reindeer : reindeers)
-    max_distance = std::max(getReindeerDistance(reindeer, 2503), max_distance);
+    max_distance =
+      std::max(getReindeerDistance(reindeer, race_time), max_distance);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = max_distance;
+  int64_t total = max_distance;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
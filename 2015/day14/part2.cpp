@@ -12,6 +12,14 @@
  * and calculates the points each reindeer accumulates over the race period. The
  * goal is to determine which reindeer has the most points after the race ends.
  *
+ * Distances are computed in closed form, and scoring only stops at fly/rest
+ * boundaries: between two boundaries every reindeer moves in a straight line,
+ * so the leaders of each second follow from the upper envelope of those lines.
+ * Reindeer whose average speed can no longer catch the fastest one are
+ * dropped, and once only the fastest remain the race is periodic and the rest
+ * is fast-forwarded. The race duration can be given as a second argument
+ * (e.g. `part2 input 1000000000`).
+ *
  * Example Input:
  * - Comet can fly 14 km/s for 10 seconds, but then must rest for 127 seconds.
  * - Dancer can fly 16 km/s for 11 seconds, but then must rest for 162 seconds.
@@ -25,9 +33,13 @@
  * @author [gabrielzschmitz]
  * @date [03/09/2024]
  */
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <numeric>
+#include <queue>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -75,28 +87,215 @@ std::tuple<int, int, int> parseInput(std::string input) {
   return current;
 }
 
-std::vector<int> getReindeerDistanceOverTime(
-  const std::tuple<int, int, int>& reindeer, int total_time) {
-  int speed = std::get<0>(reindeer);
-  int fly_time = std::get<1>(reindeer);
-  int rest_time = std::get<2>(reindeer);
-
-  int cycle_time = fly_time + rest_time;
-  std::vector<int> distances(total_time + 1, 0);
-
-  int current_distance = 0;
-  for (int current_time = 1; current_time <= total_time; ++current_time) {
-    bool is_moving = (current_time % cycle_time <= fly_time) &&
-                     (current_time % cycle_time != 0);
-    if (is_moving) current_distance += speed;
-    distances[current_time] = current_distance;
+struct Reindeer {
+  std::string name;
+  int64_t speed;
+  int64_t fly_time;
+  int64_t rest_time;
+
+  int64_t cycle() const { return fly_time + rest_time; }
+};
+
+const int64_t NEVER = std::numeric_limits<int64_t>::max();
+
+int64_t getReindeerDistance(const Reindeer& reindeer, int64_t time) {
+  int64_t full_cycles = time / reindeer.cycle();
+  int64_t remaining_time = time % reindeer.cycle();
+  return reindeer.speed * (full_cycles * reindeer.fly_time +
+                           std::min(remaining_time, reindeer.fly_time));
+}
+
+/* Speed during the second that ends at time + 1. */
+int64_t getReindeerSpeed(const Reindeer& reindeer, int64_t time) {
+  return (time % reindeer.cycle() < reindeer.fly_time) ? reindeer.speed : 0;
+}
+
+/* First time after `time` at which the reindeer starts or stops flying. */
+int64_t getNextBoundary(const Reindeer& reindeer, int64_t time) {
+  int64_t phase = time % reindeer.cycle();
+  if (phase < reindeer.fly_time) return time - phase + reindeer.fly_time;
+  return time - phase + reindeer.cycle();
+}
+
+/*
+ * The distance of a reindeer never drops below average_speed * t and never
+ * exceeds it by more than speed * fly_time * rest_time / cycle. Returns the
+ * last second at which `slower` can still be level with `fastest`.
+ */
+int64_t getLastChance(const Reindeer& fastest, const Reindeer& slower) {
+  __int128 excess =
+    (__int128)slower.speed * slower.fly_time * slower.rest_time *
+    fastest.cycle();
+  __int128 gap = (__int128)fastest.speed * fastest.fly_time * slower.cycle() -
+                 (__int128)slower.speed * slower.fly_time * fastest.cycle();
+  if (gap <= 0) return NEVER;
+  __int128 last = excess / gap;
+  return (last >= NEVER) ? NEVER - 1 : (int64_t)last;
+}
+
+int64_t floorDiv(__int128 a, __int128 b) {
+  __int128 q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+  return (int64_t)q;
+}
+
+int64_t ceilDiv(__int128 a, __int128 b) { return -floorDiv(-a, b); }
+
+struct Line {
+  int64_t slope;
+  int64_t start;
+  std::vector<int> members;
+};
+
+/*
+ * Awards the seconds time + 1 .. time + length, during which every contender
+ * moves at a constant speed. Each second goes to the lines on the upper
+ * envelope at that point, including every line tied at a crossing.
+ */
+void awardInterval(const std::vector<Reindeer>& reindeers,
+                   const std::vector<int>& contenders, int64_t time,
+                   int64_t length, std::vector<int64_t>& points) {
+  std::vector<std::tuple<int64_t, int64_t, int>> lines;
+  for (int index : contenders)
+    lines.emplace_back(getReindeerSpeed(reindeers[index], time),
+                       getReindeerDistance(reindeers[index], time), index);
+  std::sort(lines.begin(), lines.end());
+
+  std::vector<Line> hull;
+  for (size_t i = 0, group_end = 0; i < lines.size(); i++) {
+    int64_t slope = std::get<0>(lines[i]), start = std::get<1>(lines[i]);
+    if (group_end <= i) {
+      group_end = i;
+      while (group_end < lines.size() && std::get<0>(lines[group_end]) == slope)
+        group_end++;
+    }
+    if (std::get<1>(lines[group_end - 1]) > start) continue;
+    if (!hull.empty() && hull.back().slope == slope) {
+      hull.back().members.push_back(std::get<2>(lines[i]));
+      continue;
+    }
+    while (hull.size() >= 2) {
+      const Line& first = hull[hull.size() - 2];
+      const Line& middle = hull.back();
+      __int128 left = (__int128)(first.start - middle.start) *
+                      (slope - middle.slope);
+      __int128 right = (__int128)(middle.start - start) *
+                       (middle.slope - first.slope);
+      if (left <= right) break;
+      hull.pop_back();
+    }
+    hull.push_back({slope, start, {std::get<2>(lines[i])}});
+  }
+
+  for (size_t i = 0; i < hull.size(); i++) {
+    int64_t from = 1, to = length;
+    if (i > 0)
+      from = std::max(from, ceilDiv(hull[i - 1].start - hull[i].start,
+                                    hull[i].slope - hull[i - 1].slope));
+    if (i + 1 < hull.size())
+      to = std::min(to, floorDiv(hull[i].start - hull[i + 1].start,
+                                 hull[i + 1].slope - hull[i].slope));
+    if (from > to) continue;
+    for (int index : hull[i].members)
+      points[index] += to - from + 1;
+  }
+}
+
+/*
+ * Scores the seconds from + 1 .. to, stopping only at fly/rest boundaries and
+ * at the last chance of a contender. `contenders` is sorted by descending last
+ * chance and loses its members as they drop out of the race.
+ */
+void scoreRange(const std::vector<Reindeer>& reindeers,
+                const std::vector<int64_t>& last_chance,
+                std::vector<int>& contenders, int64_t from, int64_t to,
+                std::vector<int64_t>& points) {
+  typedef std::pair<int64_t, int> Event;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  for (int index : contenders)
+    events.push({getNextBoundary(reindeers[index], from), index});
+
+  int64_t time = from;
+  while (time < to) {
+    while (!contenders.empty() && last_chance[contenders.back()] <= time)
+      contenders.pop_back();
+    while (!events.empty() && last_chance[events.top().second] <= time)
+      events.pop();
+
+    int64_t next = to;
+    if (!events.empty()) next = std::min(next, events.top().first);
+    if (!contenders.empty())
+      next = std::min(next, last_chance[contenders.back()]);
+
+    awardInterval(reindeers, contenders, time, next - time, points);
+    time = next;
+
+    while (!events.empty() && events.top().first <= time) {
+      int index = events.top().second;
+      events.pop();
+      events.push({getNextBoundary(reindeers[index], time), index});
+    }
+  }
+}
+
+std::vector<int64_t> scoreRace(const std::vector<Reindeer>& reindeers,
+                               int64_t duration) {
+  std::vector<int64_t> points(reindeers.size(), 0);
+  if (reindeers.empty()) return points;
+
+  int fastest = 0;
+  for (size_t i = 1; i < reindeers.size(); i++)
+    if (getLastChance(reindeers[i], reindeers[fastest]) != NEVER) fastest = i;
+
+  std::vector<int64_t> last_chance(reindeers.size());
+  std::vector<int> contenders;
+  int64_t last_drop = 0;
+  for (size_t i = 0; i < reindeers.size(); i++) {
+    last_chance[i] = getLastChance(reindeers[fastest], reindeers[i]);
+    contenders.push_back(i);
+    if (last_chance[i] != NEVER)
+      last_drop = std::max(last_drop, last_chance[i]);
+  }
+  std::sort(contenders.begin(), contenders.end(),
+            [&](int a, int b) { return last_chance[a] > last_chance[b]; });
+
+  int64_t time = std::min(duration, last_drop);
+  scoreRange(reindeers, last_chance, contenders, 0, time, points);
+  if (time == duration) return points;
+
+  while (!contenders.empty() && last_chance[contenders.back()] != NEVER)
+    contenders.pop_back();
+  if (contenders.size() == 1) {
+    points[contenders[0]] += duration - time;
+    return points;
   }
 
-  return distances;
+  int64_t period = 1;
+  for (int index : contenders) {
+    int64_t cycle = reindeers[index].cycle();
+    int64_t common = std::gcd(period, cycle);
+    if (period / common > (duration - time) / cycle) {
+      period = NEVER;
+      break;
+    }
+    period = period / common * cycle;
+  }
+  if (period <= duration - time) {
+    std::vector<int64_t> before = points;
+    scoreRange(reindeers, last_chance, contenders, time, time + period,
+               points);
+    int64_t repeats = (duration - time) / period;
+    for (size_t i = 0; i < points.size(); i++)
+      points[i] += (points[i] - before[i]) * (repeats - 1);
+    time += repeats * period;
+  }
+  scoreRange(reindeers, last_chance, contenders, time, duration, points);
+  return points;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int64_t race_time = (argc >= 3) ? std::stoll(argv[2]) : TIME;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -106,46 +305,32 @@ int main(int argc, char* argv[]) {
   }
 
   std::string line;
-  std::map<std::string, std::tuple<int, int, int>> reindeers;
-  std::map<std::string, std::vector<int>> allTraveledDistances;
-  std::map<std::string, int> reindeerPoints;
+  std::vector<Reindeer> reindeers;
 
   while (std::getline(input_file, line)) {
-    std::string name = getReindeerName(line);
     auto reindeer_tuple = parseInput(line);
-    reindeers[name] = reindeer_tuple;
-    allTraveledDistances[name] =
-      getReindeerDistanceOverTime(reindeer_tuple, TIME);
-    reindeerPoints[name] = 0;
+    reindeers.push_back({getReindeerName(line), std::get<0>(reindeer_tuple),
+                         std::get<1>(reindeer_tuple),
+                         std::get<2>(reindeer_tuple)});
   }
 
   if (debug)
     for (const auto& reindeer : reindeers)
-      std::cout << reindeer.first << " -> " << std::get<0>(reindeer.second)
-                << "km/s " << std::get<1>(reindeer.second) << "s "
-                << std::get<2>(reindeer.second) << "s" << std::endl;
-
-  for (int current_time = 1; current_time <= TIME; ++current_time) {
-    int max_distance = 0;
-
-    for (const auto& reindeer : allTraveledDistances)
-      max_distance = std::max(max_distance, reindeer.second[current_time]);
-
-    for (auto& reindeer : reindeerPoints)
-      if (allTraveledDistances[reindeer.first][current_time] == max_distance)
-        reindeer.second++;
-  }
+      std::cout << reindeer.name << " -> " << reindeer.speed << "km/s "
+                << reindeer.fly_time << "s " << reindeer.rest_time << "s"
+                << std::endl;
 
-  int max_points = 0;
-  for (const auto& reindeer : reindeerPoints)
-    max_points = std::max(max_points, reindeer.second);
+  std::vector<int64_t> points = scoreRace(reindeers, race_time);
+  int64_t max_points = 0;
+  for (int64_t reindeer_points : points)
+    max_points = std::max(max_points, reindeer_points);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = max_points;
+  int64_t total = max_points;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -14,6 +14,12 @@
  * treated as zero in the multiplication. The goal is to find the combination of
  * ingredients that yields the highest possible cookie score.
  *
+ * The search works for any number of ingredients and any amount of teaspoons
+ * (`part1 input [teaspoons]`). It enumerates the splits recursively with
+ * running property totals, cuts branches that can only score zero or cannot
+ * beat the best score so far, and divides the first ingredient's range
+ * between threads.
+ *
  * Example Input:
  * - Butterscotch: capacity -1, durability -2, flavor 6, texture 3, calories 8
  * - Cinnamon: capacity 2, durability 3, flavor -2, texture -1, calories 3
@@ -28,9 +34,14 @@
  * @date [04/09/2024]
  */
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -68,27 +79,285 @@ std::vector<Ingredient> parseInput(std::ifstream& input_file) {
   return ingredients;
 }
 
-int calculateScore(const std::vector<Ingredient>& ingredients,
-                   const std::vector<int>& amounts) {
-  int capacity = 0, durability = 0, flavor = 0, texture = 0;
+const int PROPERTIES = 4;
+const int NO_CALORIE_TARGET = -1;
+
+/*
+ * Branch-and-bound over every way of splitting the teaspoons between the
+ * ingredients. Property totals are updated incrementally; a branch is cut
+ * when a property can no longer end up positive, when the calorie target is
+ * out of reach, or when even the best case cannot beat the best score found.
+ */
+class RecipeSearch {
+ public:
+  RecipeSearch(const std::vector<Ingredient>& ingredients, int teaspoons,
+               int calorie_target)
+    : count(ingredients.size()),
+      teaspoons(teaspoons),
+      calorie_target(calorie_target),
+      values(count * (PROPERTIES + 1)),
+      max_after((count + 1) * (PROPERTIES + 1), INT_MIN),
+      min_after((count + 1) * (PROPERTIES + 1), INT_MAX),
+      best(0) {
+    for (int i = 0; i < count; i++) {
+      const Ingredient& ingredient = ingredients[i];
+      int row[PROPERTIES + 1] = {ingredient.capacity, ingredient.durability,
+                                 ingredient.flavor, ingredient.texture,
+                                 ingredient.calories};
+      std::copy(row, row + PROPERTIES + 1, &values[i * (PROPERTIES + 1)]);
+    }
+    for (int i = count - 1; i >= 0; i--)
+      for (int p = 0; p <= PROPERTIES; p++) {
+        int value = values[i * (PROPERTIES + 1) + p];
+        max_after[i * (PROPERTIES + 1) + p] =
+          std::max(value, max_after[(i + 1) * (PROPERTIES + 1) + p]);
+        min_after[i * (PROPERTIES + 1) + p] =
+          std::min(value, min_after[(i + 1) * (PROPERTIES + 1) + p]);
+      }
+  }
 
-  for (size_t i = 0; i < ingredients.size(); ++i) {
-    capacity += ingredients[i].capacity * amounts[i];
-    durability += ingredients[i].durability * amounts[i];
-    flavor += ingredients[i].flavor * amounts[i];
-    texture += ingredients[i].texture * amounts[i];
+  int64_t solve() {
+    if (count == 0) return 0;
+    seedWithLocalSearch();
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned worker = 0; worker < workers; worker++)
+      threads.emplace_back([this, worker, workers] {
+        for (int amount = worker; amount <= teaspoons; amount += workers) {
+          int64_t sums[PROPERTIES + 1] = {0};
+          add(sums, 0, amount);
+          search(1, teaspoons - amount, sums);
+        }
+      });
+    for (auto& thread : threads)
+      thread.join();
+    return best.load();
   }
 
-  capacity = std::max(0, capacity);
-  durability = std::max(0, durability);
-  flavor = std::max(0, flavor);
-  texture = std::max(0, texture);
+ private:
+  void add(int64_t* sums, int ingredient, int amount) const {
+    for (int p = 0; p <= PROPERTIES; p++)
+      sums[p] += (int64_t)amount * values[ingredient * (PROPERTIES + 1) + p];
+  }
 
-  return capacity * durability * flavor * texture;
-}
+  bool worthExploring(int index, int remaining, const int64_t* sums) const {
+    int64_t bound = 1;
+    for (int p = 0; p < PROPERTIES; p++) {
+      int64_t most =
+        sums[p] + (int64_t)remaining * max_after[index * (PROPERTIES + 1) + p];
+      if (most <= 0) return false;
+      bound *= most;
+    }
+    if (calorie_target != NO_CALORIE_TARGET) {
+      int offset = index * (PROPERTIES + 1) + PROPERTIES;
+      int64_t least = sums[PROPERTIES] + (int64_t)remaining * min_after[offset];
+      int64_t most = sums[PROPERTIES] + (int64_t)remaining * max_after[offset];
+      if (calorie_target < least || calorie_target > most) return false;
+    }
+    int64_t current = best.load(std::memory_order_relaxed);
+    if (bound <= current) return false;
+    return current == 0 || concaveBound(index, remaining, sums) > current;
+  }
+
+  /*
+   * The log of the score is concave in the split of the remaining teaspoons,
+   * so its tangent at the even split bounds it from above. That tangent is
+   * linear and therefore peaks when one ingredient takes everything.
+   */
+  double concaveBound(int index, int remaining, const int64_t* sums) const {
+    int left = count - index;
+    double even[PROPERTIES];
+    double log_score = 0;
+    for (int p = 0; p < PROPERTIES; p++) {
+      double total = 0;
+      for (int i = index; i < count; i++)
+        total += values[i * (PROPERTIES + 1) + p];
+      even[p] = sums[p] + (double)remaining * total / left;
+      if (even[p] <= 0) return INFINITY;
+      log_score += std::log(even[p]);
+    }
+    std::vector<double> slopes(left);
+    for (int i = index; i < count; i++) {
+      double slope = 0;
+      for (int p = 0; p < PROPERTIES; p++) {
+        double corner =
+          sums[p] + (double)remaining * values[i * (PROPERTIES + 1) + p];
+        slope += (corner - even[p]) / even[p];
+      }
+      slopes[i - index] = slope;
+    }
+
+    double steepest = -INFINITY;
+    if (calorie_target == NO_CALORIE_TARGET || remaining == 0) {
+      for (double slope : slopes)
+        steepest = std::max(steepest, slope);
+    } else {
+      // With the calorie equality the peak lies on a vertex or an edge of the
+      // simplex whose calorie average matches the target.
+      double needed = (double)(calorie_target - sums[PROPERTIES]) / remaining;
+      for (int i = 0; i < left; i++) {
+        double low = values[(index + i) * (PROPERTIES + 1) + PROPERTIES];
+        if (low == needed) steepest = std::max(steepest, slopes[i]);
+        for (int j = 0; j < left; j++) {
+          double high = values[(index + j) * (PROPERTIES + 1) + PROPERTIES];
+          if (!(low < needed && needed < high)) continue;
+          double weight = (needed - low) / (high - low);
+          steepest = std::max(steepest,
+                              slopes[i] * (1 - weight) + slopes[j] * weight);
+        }
+      }
+      if (steepest == -INFINITY) return 0;
+    }
+    return std::exp(log_score + steepest) * (1 + 1e-9) + 1;
+  }
+
+  /*
+   * Hill-climbs from an even split, first towards the calorie target, then
+   * towards positive properties and finally towards a better score, so the
+   * exhaustive search starts with a strong score to prune against. Moves
+   * shift one teaspoon, or two at once to trade calories between ingredients.
+   */
+  void seedWithLocalSearch() {
+    std::vector<int> amounts(count, teaspoons / count);
+    amounts[0] += teaspoons % count;
+    auto score = [&](const std::vector<int>& candidate) {
+      int64_t sums[PROPERTIES + 1] = {0};
+      for (int i = 0; i < count; i++)
+        add(sums, i, candidate[i]);
+      if (calorie_target != NO_CALORIE_TARGET &&
+          sums[PROPERTIES] != calorie_target)
+        return -(int64_t(1) << 40) -
+               std::abs(sums[PROPERTIES] - calorie_target);
+      int64_t shortfall = 0;
+      for (int p = 0; p < PROPERTIES; p++)
+        shortfall += std::min<int64_t>(0, sums[p] - 1);
+      if (shortfall < 0) return shortfall;
+      int64_t result = 1;
+      for (int p = 0; p < PROPERTIES; p++)
+        result *= sums[p];
+      return result;
+    };
+    auto move = [&](int from, int to, int step) {
+      amounts[from] -= step;
+      amounts[to] += step;
+    };
+
+    int64_t current = score(amounts);
+    for (bool improved = true; improved;) {
+      improved = false;
+      for (int from = 0; from < count; from++)
+        for (int to = 0; to < count; to++) {
+          if (from == to || amounts[from] == 0) continue;
+          bool accepted = false;
+          move(from, to, 1);
+          for (int other = 0; other < count * count; other++) {
+            int second_from = other / count, second_to = other % count;
+            bool second = other > 0;
+            if (second && (second_from == second_to ||
+                           amounts[second_from] == 0))
+              continue;
+            if (second) move(second_from, second_to, 1);
+            int64_t candidate = score(amounts);
+            if (candidate > current) {
+              current = candidate;
+              accepted = improved = true;
+              break;
+            }
+            if (second) move(second_to, second_from, 1);
+          }
+          if (!accepted) move(to, from, 1);
+        }
+    }
+    best = std::max<int64_t>(0, current);
+    if (debug) std::cout << "local search: " << best << std::endl;
+  }
+
+  /* Narrows [from, to] to the amounts with slope * amount + offset >= 0. */
+  static void keepNonNegative(int64_t slope, int64_t offset, int& from,
+                              int& to) {
+    if (slope == 0) {
+      if (offset < 0) to = from - 1;
+    } else if (slope > 0) {
+      int64_t least = -offset / slope;
+      if (least * slope < -offset) least++;
+      if (least > from) from = std::min<int64_t>(least, to + 1);
+    } else {
+      int64_t most = offset / -slope;
+      if (most * -slope > offset) most--;
+      if (most < to) to = std::max<int64_t>(most, from - 1);
+    }
+  }
+
+  /*
+   * Keeps only the amounts of ingredient `index` after which every property
+   * can still end up positive and the calorie target is still reachable, so
+   * hopeless children are skipped without being visited.
+   */
+  void narrowAmounts(int index, int remaining, const int64_t* sums, int& from,
+                     int& to) const {
+    const int* own = &values[index * (PROPERTIES + 1)];
+    const int* most = &max_after[(index + 1) * (PROPERTIES + 1)];
+    const int* least = &min_after[(index + 1) * (PROPERTIES + 1)];
+    for (int p = 0; p < PROPERTIES; p++)
+      keepNonNegative(own[p] - most[p],
+                      sums[p] + (int64_t)remaining * most[p] - 1, from, to);
+    if (calorie_target == NO_CALORIE_TARGET) return;
+    keepNonNegative(least[PROPERTIES] - own[PROPERTIES],
+                    calorie_target - sums[PROPERTIES] -
+                      (int64_t)remaining * least[PROPERTIES],
+                    from, to);
+    keepNonNegative(own[PROPERTIES] - most[PROPERTIES],
+                    sums[PROPERTIES] + (int64_t)remaining * most[PROPERTIES] -
+                      calorie_target,
+                    from, to);
+  }
+
+  void search(int index, int remaining, int64_t* sums) {
+    if (index == count - 1 || index == count) {
+      int64_t final_sums[PROPERTIES + 1];
+      std::copy(sums, sums + PROPERTIES + 1, final_sums);
+      if (index == count - 1) add(final_sums, index, remaining);
+      else if (remaining > 0) return;
+      record(final_sums);
+      return;
+    }
+    if (!worthExploring(index, remaining, sums)) return;
+
+    int from = 0, to = remaining;
+    narrowAmounts(index, remaining, sums, from, to);
+    int64_t next[PROPERTIES + 1];
+    std::copy(sums, sums + PROPERTIES + 1, next);
+    add(next, index, from);
+    for (int amount = from; amount <= to; amount++) {
+      search(index + 1, remaining - amount, next);
+      add(next, index, 1);
+    }
+  }
+
+  void record(const int64_t* sums) {
+    if (calorie_target != NO_CALORIE_TARGET &&
+        sums[PROPERTIES] != calorie_target)
+      return;
+    int64_t score = 1;
+    for (int p = 0; p < PROPERTIES; p++)
+      score *= std::max<int64_t>(0, sums[p]);
+    int64_t current = best.load(std::memory_order_relaxed);
+    while (score > current && !best.compare_exchange_weak(current, score)) {
+    }
+  }
+
+  int count;
+  int teaspoons;
+  int calorie_target;
+  std::vector<int> values;
+  std::vector<int> max_after;
+  std::vector<int> min_after;
+  std::atomic<int64_t> best;
+};
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int teaspoons = (argc >= 3) ? std::stoi(argv[2]) : 100;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -104,29 +373,10 @@ int main(int argc, char* argv[]) {
 
   std::vector<Ingredient> ingredients = parseInput(input_file);
 
-  int best_score = 0;
-
-  int num_ingredients = ingredients.size();
-  std::vector<int> amounts(num_ingredients);
-
-  for (amounts[0] = 0; amounts[0] <= 100; ++amounts[0]) {
-    for (amounts[1] = 0; amounts[1] <= 100 - amounts[0]; ++amounts[1]) {
-      if (num_ingredients > 2) {
-        for (amounts[2] = 0; amounts[2] <= 100 - amounts[0] - amounts[1];
-             ++amounts[2]) {
-          amounts[3] = 100 - amounts[0] - amounts[1] - amounts[2];
-          int score = calculateScore(ingredients, amounts);
-          best_score = std::max(best_score, score);
-        }
-      } else {
-        amounts[2] = 100 - amounts[0] - amounts[1];
-        int score = calculateScore(ingredients, amounts);
-        best_score = std::max(best_score, score);
-      }
-    }
-  }
+  RecipeSearch search(ingredients, teaspoons, NO_CALORIE_TARGET);
+  int64_t best_score = search.solve();
 
-  int total = best_score;
+  int64_t total = best_score;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -34,17 +34,28 @@
  * criteria and outputs the number of the real Aunt Sue who matches the updated 
  * MFCSAM analysis.
  *
+ * The Sues are parsed once into a table with an int8_t column per compound,
+ * unknown values marked by a sentinel. The ticker tape is compiled into one
+ * range per compound and checked against 32 Sues at a time with vector
+ * compares. An optional second argument names a file of ticker tapes, one per
+ * line, to look up in a batch.
+ *
  * Puzzle Answer: [Real Aunt Sue Number]
  *
  * @author [gabrielzschmitz]
  * @date [05/09/2024]
  */
+#include <immintrin.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <functional>
 #include <iostream>
-#include <map>
-#include <regex>
 #include <string>
+#include <vector>
 
 bool debug = false;
 
@@ -55,49 +66,151 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-std::map<std::string, std::function<bool(int)>> SIGNATURE = {
-  {"children",
-   [](int value) {
-     return value == 3;
-   }},
-  {"cats",
-   [](int value) {
-     return value > 7;
-   }},
-  {"samoyeds",
-   [](int value) {
-     return value == 2;
-   }},
-  {"pomeranians",
-   [](int value) {
-     return value < 3;
-   }},
-  {"akitas",
-   [](int value) {
-     return value == 0;
-   }},
-  {"vizslas",
-   [](int value) {
-     return value == 0;
-   }},
-  {"goldfish",
-   [](int value) {
-     return value < 5;
-   }},
-  {"trees",
-   [](int value) {
-     return value > 3;
-   }},
-  {"cars",
-   [](int value) {
-     return value == 2;
-   }},
-  {"perfumes", [](int value) {
-     return value == 1;
-   }}};
+const int COMPOUND_COUNT = 10;
+const char* const COMPOUNDS[COMPOUND_COUNT] = {
+  "children", "cats",    "samoyeds", "pomeranians", "akitas",
+  "vizslas",  "goldfish", "trees",   "cars",        "perfumes"};
+enum Compound { Cats = 1, Pomeranians = 3, Goldfish = 6, Trees = 7 };
+
+const int NO_READING = -1;
+const int TICKER_TAPE[COMPOUND_COUNT] = {3, 7, 2, 3, 0, 0, 5, 3, 2, 1};
+
+/* Column value for a compound nobody remembers; it matches any reading. */
+const int8_t UNKNOWN = INT8_MIN;
+
+int compoundIndex(const char* name, size_t length) {
+  for (int i = 0; i < COMPOUND_COUNT; i++)
+    if (std::strlen(COMPOUNDS[i]) == length &&
+        std::strncmp(COMPOUNDS[i], name, length) == 0)
+      return i;
+  return -1;
+}
+
+/*
+ * Parses "name: value, name: value, ..." into one value per compound, leaving
+ * the rest as `missing`. Fails on unknown compounds or values outside 0-127.
+ */
+bool parseCompounds(const char* text, int values[COMPOUND_COUNT],
+                    int missing) {
+  std::fill(values, values + COMPOUND_COUNT, missing);
+  while (*text) {
+    while (*text == ' ' || *text == ',')
+      text++;
+    if (*text == '\0' || *text == '\n' || *text == '\r') break;
+    const char* colon = std::strchr(text, ':');
+    if (colon == nullptr) return false;
+    int compound = compoundIndex(text, colon - text);
+    char* end;
+    long value = std::strtol(colon + 1, &end, 10);
+    if (compound < 0 || end == colon + 1 || value < 0 || value > INT8_MAX)
+      return false;
+    values[compound] = value;
+    text = end;
+  }
+  return true;
+}
+
+/* The Sues as columns: one int8_t per Sue for each compound. */
+class SueTable {
+ public:
+  /* Adds a "Sue N: name: value, ..." line. */
+  bool addSue(const std::string& line) {
+    if (line.compare(0, 4, "Sue ") != 0) return false;
+    char* end;
+    long number = std::strtol(line.c_str() + 4, &end, 10);
+    int values[COMPOUND_COUNT];
+    if (*end != ':' || !parseCompounds(end + 1, values, UNKNOWN))
+      return false;
+    numbers.push_back(number);
+    for (int i = 0; i < COMPOUND_COUNT; i++)
+      columns[i].push_back(values[i]);
+    return true;
+  }
+
+  size_t size() const { return numbers.size(); }
+  int number(size_t row) const { return numbers[row]; }
+  const int8_t* column(int compound) const { return columns[compound].data(); }
+
+ private:
+  std::vector<int> numbers;
+  std::vector<int8_t> columns[COMPOUND_COUNT];
+};
+
+/* Allowed values [low, high] for each compound; UNKNOWN always passes. */
+struct TickerQuery {
+  int8_t low[COMPOUND_COUNT];
+  int8_t high[COMPOUND_COUNT];
+};
+
+/*
+ * Turns ticker readings into ranges: cats and trees read as lower bounds,
+ * pomeranians and goldfish as upper bounds, the rest exactly. A compound
+ * without a reading accepts anything.
+ */
+TickerQuery compileTicker(const int readings[COMPOUND_COUNT]) {
+  TickerQuery query;
+  for (int i = 0; i < COMPOUND_COUNT; i++) {
+    int low = readings[i], high = readings[i];
+    if (readings[i] == NO_READING) low = 0, high = INT8_MAX;
+    else if (i == Cats || i == Trees) low++, high = INT8_MAX;
+    else if (i == Pomeranians || i == Goldfish) low = 0, high--;
+    if (low > high) low = INT8_MAX, high = 0;  // nothing can match
+    query.low[i] = low;
+    query.high[i] = high;
+  }
+  return query;
+}
+
+uint32_t matchBlockScalar(const SueTable& sues, const TickerQuery& query,
+                          size_t first, size_t count) {
+  uint32_t matches = (count == 32) ? ~0u : (1u << count) - 1;
+  for (int i = 0; i < COMPOUND_COUNT && matches; i++) {
+    const int8_t* values = sues.column(i) + first;
+    uint32_t passing = 0;
+    for (size_t row = 0; row < count; row++)
+      if (values[row] == UNKNOWN ||
+          (query.low[i] <= values[row] && values[row] <= query.high[i]))
+        passing |= 1u << row;
+    matches &= passing;
+  }
+  return matches;
+}
+
+/* The same 32 Sues at a time, one compare per bound and column. */
+__attribute__((target("avx2"))) uint32_t matchBlockAvx2(
+  const SueTable& sues, const TickerQuery& query, size_t first) {
+  const __m256i unknown = _mm256_set1_epi8(UNKNOWN);
+  uint32_t matches = ~0u;
+  for (int i = 0; i < COMPOUND_COUNT && matches; i++) {
+    __m256i values = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(sues.column(i) + first));
+    __m256i outside = _mm256_or_si256(
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(query.low[i]), values),
+      _mm256_cmpgt_epi8(values, _mm256_set1_epi8(query.high[i])));
+    uint32_t outside_bits = _mm256_movemask_epi8(outside);
+    uint32_t unknown_bits =
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(values, unknown));
+    matches &= ~outside_bits | unknown_bits;
+  }
+  return matches;
+}
+
+/* The number of the first Sue matching the query, or 0 if none does. */
+int findSue(const SueTable& sues, const TickerQuery& query) {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  for (size_t first = 0; first < sues.size(); first += 32) {
+    size_t count = std::min<size_t>(32, sues.size() - first);
+    uint32_t matches = (has_avx2 && count == 32)
+                         ? matchBlockAvx2(sues, query, first)
+                         : matchBlockScalar(sues, query, first, count);
+    if (matches) return sues.number(first + __builtin_ctz(matches));
+  }
+  return 0;
+}
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  std::string tapes_path = (argc >= 3) ? argv[2] : "";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -107,31 +220,49 @@ int main(int argc, char* argv[]) {
   }
 
   std::string line;
-  std::regex auntRegex(
-    R"(Sue (\d+): (\w+): (\d+), (\w+): (\d+), (\w+): (\d+))");
-  std::smatch match;
-
-  int total = 0;
-  while (std::getline(input_file, line)) {
-    if (std::regex_search(line, match, auntRegex)) {
-      int auntNumber = std::stoi(match[1]);
-      std::string attr1 = match[2], attr2 = match[4], attr3 = match[6];
-      int value1 = std::stoi(match[3]), value2 = std::stoi(match[5]),
-          value3 = std::stoi(match[7]);
-
-      if (SIGNATURE[attr1](value1) && SIGNATURE[attr2](value2) &&
-          SIGNATURE[attr3](value3)) {
-        total = auntNumber;
-        break;
-      }
+  SueTable sues;
+  while (std::getline(input_file, line))
+    if (!line.empty() && !sues.addSue(line)) {
+      std::cerr << "Error: Bad Sue \"" << line << "\"" << std::endl;
+      return 1;
     }
-  }
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
+  // Each line of the optional tapes file is one ticker tape to look up.
+  std::vector<TickerQuery> queries = {compileTicker(TICKER_TAPE)};
+  if (!tapes_path.empty()) {
+    std::ifstream tapes_file(tapes_path);
+    if (!tapes_file.is_open()) {
+      std::cerr << "FILE " << tapes_path << " UNAVAILABLE!" << std::endl;
+      return 1;
+    }
+    queries.clear();
+    int readings[COMPOUND_COUNT];
+    while (std::getline(tapes_file, line)) {
+      if (line.empty()) continue;
+      if (!parseCompounds(line.c_str(), readings, NO_READING)) {
+        std::cerr << "Error: Bad ticker tape \"" << line << "\"" << std::endl;
+        return 1;
+      }
+      queries.push_back(compileTicker(readings));
+    }
+    if (tapes_file.bad()) {
+      std::cerr << "Error reading the file!" << std::endl;
+      return 1;
+    }
+  }
+
+  int total = 0;
+  for (size_t i = 0; i < queries.size(); i++) {
+    total = findSue(sues, queries[i]);
+    if (queries.size() > 1)
+      std::cout << "tape " << i + 1 << ": " << total << "\n";
+  }
+
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -29,46 +29,67 @@
  * Example Output:
  * - Number of valid combinations: 4
  *
+ * Instead of trying every subset, the number of ways to hold each volume is
+ * built up one container at a time in a single O(n * V) table. The target
+ * volume can be passed as a second argument (defaults to 150, or 25 for the
+ * test file).
+ *
  * Puzzle Answer: [Number of Combinations]
  *
  * @author [gabrielzschmitz]
  * @date [06/09/2024]
  */
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
 bool debug = false;
-int liters_of_eggnog = 150;
 
 void checkDebugFlag(const std::string& input, bool& debug) {
   size_t pos = input.find_last_of('/');
   std::string last_part =
     (pos == std::string::npos) ? input : input.substr(pos + 1);
-  if (last_part == "test") {
-    debug = true;
-    liters_of_eggnog = 25;
-  }
+  if (last_part == "test") debug = true;
 }
 
-void findCombinations(const std::vector<int>& containers, int index,
-                      int current_sum, int& total) {
-  if (current_sum == liters_of_eggnog) {
-    total++;
-    return;
-  }
+/* Adds without wrapping around, sticking at the largest count instead. */
+inline uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+  uint64_t sum = a + b;
+  return sum | -(uint64_t)(sum < a);
+}
 
-  if (current_sum > liters_of_eggnog || index >= containers.size()) return;
+/*
+ * Fills ways[v], the number of ways to pick containers holding exactly v
+ * liters, one container at a time. Volumes are updated from the top down, so
+ * each container is used at most once. Counts saturate at 2^64 - 1.
+ */
+uint64_t countCombinations(std::vector<int> containers, int volume) {
+  if (volume < 0) return 0;
+  // Largest first, so the containers still to come soon stop being able to
+  // fill the target from low volumes, which are then never read again.
+  std::sort(containers.rbegin(), containers.rend());
+  long long remaining = 0;
+  for (int size : containers)
+    remaining += size;
 
-  findCombinations(containers, index + 1, current_sum + containers[index],
-                   total);
-  findCombinations(containers, index + 1, current_sum, total);
+  std::vector<uint64_t> ways(volume + 1, 0);
+  ways[0] = 1;
+  for (int size : containers) {
+    remaining -= size;
+    long long first = std::max<long long>(size, volume - remaining);
+    for (long long v = volume; v >= first; v--)
+      ways[v] = saturatingAdd(ways[v], ways[v - size]);
+  }
+  return ways[volume];
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
+  int liters_of_eggnog = (argc >= 3) ? std::stoi(argv[2]) : (debug ? 25 : 150);
 
   std::ifstream input_file(user_input);
   if (!input_file.is_open()) {
@@ -76,8 +97,6 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  int total = 0;
-
   std::string line;
   std::vector<int> containers;
   while (std::getline(input_file, line)) {
@@ -88,13 +107,19 @@ int main(int argc, char* argv[]) {
     for (int i : containers)
       std::cout << i << " \n";
 
-  findCombinations(containers, 0, 0, total);
+  uint64_t combinations = countCombinations(containers, liters_of_eggnog);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  std::cout << "ANSWER: " << total << std::endl;
+  if (combinations == UINT64_MAX) {
+    std::cerr << "Error: The number of combinations overflows 64 bits."
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << "ANSWER: " << combinations << std::endl;
   return 0;
 }
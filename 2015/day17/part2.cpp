@@ -30,56 +30,92 @@
  * - Minimum number of containers: 2
  * - Number of valid combinations: 3
  *
+ * Instead of trying every subset, the fewest containers holding each volume and
+ * the number of ways to do it with that many are built up one container at a
+ * time, in O(n * V) for n containers and target volume V. The target
+ * volume can be passed as a second argument (defaults to 150, or 25 for the
+ * test file).
+ *
  * Puzzle Answer: [Number of Valid Combinations]
  *
  * @author [gabrielzschmitz]
  * @date [06/09/2024]
  */
+#include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
 bool debug = false;
-int liters_of_eggnog = 150;
 
 void checkDebugFlag(const std::string& input, bool& debug) {
   size_t pos = input.find_last_of('/');
   std::string last_part =
     (pos == std::string::npos) ? input : input.substr(pos + 1);
-  if (last_part == "test") {
-    debug = true;
-    liters_of_eggnog = 25;
-  }
+  if (last_part == "test") debug = true;
 }
 
-void findCombinations(const std::vector<int>& containers, int index,
-                      int current_sum, int current_containers, int& total,
-                      int& min_containers, int& ways_with_min) {
-  if (current_sum == liters_of_eggnog) {
-    total++;
-    if (current_containers < min_containers) {
-      min_containers = current_containers;
-      ways_with_min = 1;
-    } else if (current_containers == min_containers) {
-      ways_with_min++;
+struct ContainerCombinations {
+  int min_containers = 0;
+  uint64_t ways_with_min = 0;
+};
+
+/* Adds without wrapping around, sticking at the largest count instead. */
+inline uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+  uint64_t sum = a + b;
+  return sum | -(uint64_t)(sum < a);
+}
+
+/*
+ * For every volume v, keeps the fewest containers holding exactly v liters and
+ * the number of ways to do it with that many, adding one container at a time.
+ * Volumes are updated from the top down, so each container is used at most
+ * once. Counts saturate at 2^64 - 1.
+ */
+ContainerCombinations countCombinations(std::vector<int> containers,
+                                        int volume) {
+  ContainerCombinations result;
+  if (volume < 0) return result;
+  // Largest first, so the containers still to come soon stop being able to
+  // fill the target from low volumes, which are then never read again.
+  std::sort(containers.rbegin(), containers.rend());
+  long long remaining = 0;
+  for (int size : containers)
+    remaining += size;
+
+  std::vector<int> fewest(volume + 1, INT_MAX);
+  std::vector<uint64_t> ways(volume + 1, 0);
+  fewest[0] = 0;
+  ways[0] = 1;
+  for (int size : containers) {
+    remaining -= size;
+    long long first = std::max<long long>(size, volume - remaining);
+    for (long long v = volume; v >= first; v--) {
+      if (fewest[v - size] == INT_MAX) continue;
+      int count = fewest[v - size] + 1;
+      if (count < fewest[v]) {
+        fewest[v] = count;
+        ways[v] = ways[v - size];
+      } else if (count == fewest[v]) {
+        ways[v] = saturatingAdd(ways[v], ways[v - size]);
+      }
     }
-    return;
   }
 
-  if (current_sum > liters_of_eggnog || index >= containers.size()) { return; }
-
-  findCombinations(containers, index + 1, current_sum + containers[index],
-                   current_containers + 1, total, min_containers,
-                   ways_with_min);
-  findCombinations(containers, index + 1, current_sum, current_containers,
-                   total, min_containers, ways_with_min);
+  if (fewest[volume] != INT_MAX) {
+    result.min_containers = fewest[volume];
+    result.ways_with_min = ways[volume];
+  }
+  return result;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
+  int liters_of_eggnog = (argc >= 3) ? std::stoi(argv[2]) : (debug ? 25 : 150);
 
   std::ifstream input_file(user_input);
   if (!input_file.is_open()) {
@@ -97,18 +133,24 @@ int main(int argc, char* argv[]) {
     for (int i : containers)
       std::cout << i << " \n";
 
-  int total_combinations = 0;
-  int min_containers = INT_MAX;
-  int ways_with_min_containers = 0;
-  findCombinations(containers, 0, 0, 0, total_combinations, min_containers,
-                   ways_with_min_containers);
+  ContainerCombinations combinations =
+    countCombinations(containers, liters_of_eggnog);
+  if (debug)
+    std::cout << "min containers: " << combinations.min_containers
+              << std::endl;
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
-  int total = ways_with_min_containers;
+  if (combinations.ways_with_min == UINT64_MAX) {
+    std::cerr << "Error: The number of combinations overflows 64 bits."
+              << std::endl;
+    return 1;
+  }
+
+  uint64_t total = combinations.ways_with_min;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
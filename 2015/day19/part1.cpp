@@ -33,15 +33,24 @@
  * replacement on the provided input molecule using the set of given replacement
  * rules.
  *
+ * Molecules are split into atom ids, and each replacement is hashed in O(1)
+ * from prefix hashes of its parent instead of being built as a string. Only
+ * candidates with equal hashes are compared. An optional second argument runs
+ * more rounds, counting the molecules exactly that many replacements away.
+ *
  * Puzzle Answer: [Number of Distinct Molecules]
  *
  * @author [gabrielzschmitz]
  * @date [08/09/2024]
  */
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <set>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -54,8 +63,226 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
+typedef std::vector<uint32_t> Molecule;
+
+/*
+ * Gives every atom an id. An atom is an uppercase letter with its lowercase
+ * tail, or a lone lowercase letter such as the starting "e".
+ */
+class AtomTable {
+ public:
+  Molecule tokenize(const std::string& text) {
+    Molecule atoms;
+    for (size_t start = 0; start < text.size();) {
+      size_t end = start + 1;
+      if (std::isupper(text[start]))
+        while (end < text.size() && std::islower(text[end]))
+          end++;
+      atoms.push_back(idOf(text.substr(start, end - start)));
+      start = end;
+    }
+    return atoms;
+  }
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids;
+
+  // Ids start at 1 so that no atom hashes like an empty prefix.
+  uint32_t idOf(const std::string& name) {
+    auto found = ids.emplace(name, ids.size() + 1);
+    return found.first->second;
+  }
+};
+
+struct Replacement {
+  Molecule from;
+  Molecule to;
+};
+
+const uint64_t HASH_MODULUS = (1ULL << 61) - 1;
+const uint64_t HASH_BASE = 1000003;
+
+uint64_t mulMod(uint64_t a, uint64_t b) {
+  unsigned __int128 product = (unsigned __int128)a * b;
+  uint64_t folded =
+    (uint64_t)(product & HASH_MODULUS) + (uint64_t)(product >> 61);
+  return folded >= HASH_MODULUS ? folded - HASH_MODULUS : folded;
+}
+
+uint64_t addMod(uint64_t a, uint64_t b) {
+  uint64_t sum = a + b;
+  return sum >= HASH_MODULUS ? sum - HASH_MODULUS : sum;
+}
+
+uint64_t subMod(uint64_t a, uint64_t b) {
+  return a >= b ? a - b : a + HASH_MODULUS - b;
+}
+
+/* Polynomial hashes of every prefix of a molecule. */
+class PrefixHashes {
+ public:
+  explicit PrefixHashes(const Molecule& atoms) : prefix(atoms.size() + 1, 0) {
+    for (size_t i = 0; i < atoms.size(); i++)
+      prefix[i + 1] = addMod(mulMod(prefix[i], HASH_BASE), atoms[i]);
+  }
+
+  /* Hash of atoms [from, to), given the powers of the base. */
+  uint64_t range(size_t from, size_t to,
+                 const std::vector<uint64_t>& powers) const {
+    return subMod(prefix[to], mulMod(prefix[from], powers[to - from]));
+  }
+
+ private:
+  std::vector<uint64_t> prefix;
+};
+
+void growPowers(std::vector<uint64_t>& powers, size_t length) {
+  if (powers.empty()) powers.push_back(1);
+  while (powers.size() <= length)
+    powers.push_back(mulMod(powers.back(), HASH_BASE));
+}
+
+uint64_t hashOf(const Molecule& atoms) {
+  uint64_t hash = 0;
+  for (uint32_t atom : atoms)
+    hash = addMod(mulMod(hash, HASH_BASE), atom);
+  return hash;
+}
+
+/* One replacement applied to a molecule of the previous round. */
+struct Candidate {
+  uint64_t hash;
+  size_t length;
+  uint32_t parent;
+  uint32_t position;
+  uint32_t rule;
+};
+
+/* Reads the atoms of a candidate without building it. */
+struct CandidateView {
+  const Molecule& parent;
+  const Replacement& rule;
+  size_t position;
+
+  uint32_t operator[](size_t i) const {
+    if (i < position) return parent[i];
+    if (i < position + rule.to.size()) return rule.to[i - position];
+    return parent[i - rule.to.size() + rule.from.size()];
+  }
+};
+
+/*
+ * Confirms two candidates with equal hashes are really the same molecule. When
+ * both come from the same parent only the span between their replacements
+ * can differ.
+ */
+bool sameMolecule(const Candidate& a, const Candidate& b,
+                  const std::vector<Molecule>& parents,
+                  const std::vector<Replacement>& rules) {
+  if (a.length != b.length) return false;
+  CandidateView first = {parents[a.parent], rules[a.rule], a.position};
+  CandidateView second = {parents[b.parent], rules[b.rule], b.position};
+  size_t from = 0, to = a.length;
+  if (a.parent == b.parent) {
+    from = std::min(a.position, b.position);
+    to = std::max(a.position + rules[a.rule].to.size(),
+                  b.position + rules[b.rule].to.size());
+  }
+  for (size_t i = from; i < to; i++)
+    if (first[i] != second[i]) return false;
+  return true;
+}
+
+/*
+ * Every distinct molecule one replacement away from any of `molecules`. Each
+ * candidate is hashed in O(1) from its parent's prefix hashes and the hash of
+ * the inserted atoms; candidates are then sorted by hash and only equal hashes
+ * are compared atom by atom. Molecules are built only if `build` is set.
+ */
+size_t expandRound(const std::vector<Molecule>& molecules,
+                   const std::vector<Replacement>& rules, bool build,
+                   std::vector<Molecule>& next) {
+  std::vector<uint64_t> from_hashes, to_hashes, powers;
+  for (const Replacement& rule : rules) {
+    from_hashes.push_back(hashOf(rule.from));
+    to_hashes.push_back(hashOf(rule.to));
+  }
+
+  std::vector<Candidate> candidates;
+  for (size_t parent = 0; parent < molecules.size(); parent++) {
+    const Molecule& atoms = molecules[parent];
+    size_t length = atoms.size();
+    size_t longest = length;
+    for (const Replacement& rule : rules)
+      longest = std::max(longest, length + rule.to.size());
+    growPowers(powers, longest);
+    PrefixHashes hashes(atoms);
+
+    for (size_t r = 0; r < rules.size(); r++) {
+      size_t from = rules[r].from.size(), to = rules[r].to.size();
+      if (from == 0 || from > length) continue;
+      for (size_t i = 0; i + from <= length; i++) {
+        if (hashes.range(i, i + from, powers) != from_hashes[r] ||
+            !std::equal(rules[r].from.begin(), rules[r].from.end(),
+                        atoms.begin() + i))
+          continue;
+        size_t rest = length - i - from;
+        uint64_t hash = mulMod(hashes.range(0, i, powers), powers[to + rest]);
+        hash = addMod(hash, mulMod(to_hashes[r], powers[rest]));
+        hash = addMod(hash, hashes.range(i + from, length, powers));
+        candidates.push_back({hash, i + to + rest, (uint32_t)parent,
+                              (uint32_t)i, (uint32_t)r});
+      }
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return std::tie(a.hash, a.length) < std::tie(b.hash, b.length);
+            });
+
+  next.clear();
+  size_t distinct = 0;
+  std::vector<const Candidate*> group;
+  for (size_t start = 0; start < candidates.size();) {
+    size_t end = start;
+    while (end < candidates.size() &&
+           candidates[end].hash == candidates[start].hash &&
+           candidates[end].length == candidates[start].length)
+      end++;
+    // Equal hashes are nearly always the same molecule; anything that is not
+    // is a collision and counts as a distinct molecule of its own.
+    group.clear();
+    for (size_t i = start; i < end; i++) {
+      bool seen = false;
+      for (const Candidate* other : group)
+        if (sameMolecule(candidates[i], *other, molecules, rules)) {
+          seen = true;
+          break;
+        }
+      if (seen) continue;
+      group.push_back(&candidates[i]);
+      distinct++;
+      if (build) {
+        const Candidate& candidate = candidates[i];
+        const Molecule& parent = molecules[candidate.parent];
+        const Replacement& rule = rules[candidate.rule];
+        Molecule molecule(parent.begin(), parent.begin() + candidate.position);
+        molecule.insert(molecule.end(), rule.to.begin(), rule.to.end());
+        molecule.insert(molecule.end(),
+                        parent.begin() + candidate.position + rule.from.size(),
+                        parent.end());
+        next.push_back(std::move(molecule));
+      }
+    }
+    start = end;
+  }
+  return distinct;
+}
+
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int rounds = (argc >= 3) ? std::stoi(argv[2]) : 1;
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -64,8 +291,9 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::vector<std::pair<std::string, std::string>> replacements;
-  std::string medicine_molecule;
+  AtomTable atoms;
+  std::vector<Replacement> replacements;
+  Molecule medicine_molecule;
   std::string line;
 
   while (std::getline(input_file, line)) {
@@ -73,11 +301,11 @@ int main(int argc, char* argv[]) {
       continue;
     } else if (line.find("=>") != std::string::npos) {
       size_t arrow_pos = line.find(" => ");
-      std::string from = line.substr(0, arrow_pos);
-      std::string to = line.substr(arrow_pos + 4);
+      Molecule from = atoms.tokenize(line.substr(0, arrow_pos));
+      Molecule to = atoms.tokenize(line.substr(arrow_pos + 4));
       replacements.push_back({from, to});
     } else {
-      medicine_molecule = line;
+      medicine_molecule = atoms.tokenize(line);
     }
   }
 
@@ -86,20 +314,16 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::set<std::string> distinct_molecules;
-
-  for (const auto& [from, to] : replacements) {
-    size_t pos = 0;
-
-    while ((pos = medicine_molecule.find(from, pos)) != std::string::npos) {
-      std::string new_molecule = medicine_molecule.substr(0, pos) + to +
-                                 medicine_molecule.substr(pos + from.size());
-      distinct_molecules.insert(new_molecule);
-      pos += from.size();
-    }
+  std::vector<Molecule> molecules = {medicine_molecule}, next;
+  size_t total = 0;
+  for (int round = 1; round <= rounds; round++) {
+    total = expandRound(molecules, replacements, round < rounds, next);
+    molecules.swap(next);
+    if (debug)
+      std::cout << "round " << round << ": " << total << " molecules"
+                << std::endl;
   }
 
-  int total = distinct_molecules.size();
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -30,15 +30,27 @@
  * starting molecule "e" into the target medicine molecule using the available
  * replacement rules.
  *
+ * Instead of a closed form that only fits the puzzle's Rn/Y/Ar rules, a
+ * bottom-up chart parser over atom ids finds the fewest replacements for any
+ * grammar whose rules each replace one atom, unit rules and cycles included.
+ * - `part2 input bench` times it on random derivations of the puzzle grammar
+ *   and of a generated grammar.
+ *
  * Puzzle Answer: [Fewest Number of Steps]
  *
  * @author [gabrielzschmitz]
  * @date [08/09/2024]
  */
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <queue>
+#include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 bool debug = false;
@@ -50,18 +62,265 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-int countOccurrences(const std::string& molecule, const std::string& token) {
-  int count = 0;
-  size_t pos = molecule.find(token);
-  while (pos != std::string::npos) {
-    ++count;
-    pos = molecule.find(token, pos + token.size());
+typedef std::vector<uint32_t> Molecule;
+
+/*
+ * Gives every atom an id. An atom is an uppercase letter with its lowercase
+ * tail, or a lone lowercase letter such as the starting "e".
+ */
+class AtomTable {
+ public:
+  Molecule tokenize(const std::string& text) {
+    Molecule atoms;
+    for (size_t start = 0; start < text.size();) {
+      size_t end = start + 1;
+      if (std::isupper(text[start]))
+        while (end < text.size() && std::islower(text[end]))
+          end++;
+      atoms.push_back(idOf(text.substr(start, end - start)));
+      start = end;
+    }
+    return atoms;
+  }
+
+  uint32_t size() const { return ids.size(); }
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids;
+
+  uint32_t idOf(const std::string& name) {
+    auto found = ids.emplace(name, ids.size() + 1);
+    return found.first->second;
+  }
+};
+
+struct Replacement {
+  Molecule from;
+  Molecule to;
+};
+
+const uint32_t UNREACHABLE = UINT32_MAX;
+const uint32_t NO_SLOT = UINT32_MAX;
+
+/* A rule whose first `dot` atoms derive the span starting at `start`. */
+struct Item {
+  uint32_t start;
+  uint32_t rule;
+  uint32_t dot;
+  uint32_t steps;
+};
+
+/*
+ * Bottom-up chart parser that finds the fewest replacements deriving a
+ * molecule from one atom. Spans are finished by end position, and for each end
+ * by decreasing start, so every shorter span they are built from is already
+ * final. Partial rules wait at the end of what they matched for the atom they
+ * need next. Every rule must replace a single atom.
+ *
+ * Only spans something derives are visited, and each item moves in O(1), so
+ * the work is the number of (start, split, end) triples the grammar can read:
+ * O(n^3) for n atoms when it is ambiguous, as the puzzle's X => XX-style rules
+ * are over long runs, and close to linear when it is not. Memory is O(n) plus
+ * the waiting items.
+ */
+class ReductionChart {
+ public:
+  ReductionChart(const std::vector<Replacement>& rules, uint32_t atom_count)
+    : rules(rules), symbols(atom_count + 1), starting_with(symbols),
+      slot_of(symbols, NO_SLOT), steps(symbols, UNREACHABLE) {
+    for (uint32_t rule = 0; rule < rules.size(); rule++) {
+      const Molecule& to = rules[rule].to;
+      if (to.size() == 1)
+        unit_rules.push_back(rule);
+      else
+        starting_with[to[0]].push_back(rule);
+      for (size_t i = 1; i < to.size(); i++)
+        if (slot_of[to[i]] == NO_SLOT) slot_of[to[i]] = slots++;
+      first_item.push_back(cheapest.size());
+      cheapest.resize(cheapest.size() + to.size() + 1, UNREACHABLE);
+    }
+  }
+
+  uint32_t minimumSteps(const Molecule& molecule, uint32_t goal) {
+    uint32_t length = molecule.size(), result = UNREACHABLE;
+    waiting.assign(length + 1, {});
+    std::vector<std::vector<Item>> pending(length);
+
+    for (uint32_t end = 1; end <= length; end++) {
+      // Only the last atom and the starts items reached are visited, latest
+      // first; an item always reaches back before the span it grew from.
+      std::priority_queue<uint32_t> starts;
+      starts.push(end - 1);
+      while (!starts.empty()) {
+        uint32_t start = starts.top();
+        starts.pop();
+        if (start == end - 1) relax(molecule[start], 0);
+        finishItems(pending[start], end, length);
+        if (touched.empty()) continue;
+        closeUnitRules();
+
+        for (uint32_t atom : touched) {
+          uint32_t cost = steps[atom];
+          if (start == 0 && end == length && atom == goal) result = cost;
+          for (uint32_t rule : starting_with[atom])
+            wait({start, rule, 1, cost}, end, length);
+          if (!waiting[start].empty() && slot_of[atom] != NO_SLOT)
+            for (const Item& item : waiting[start][slot_of[atom]]) {
+              if (pending[item.start].empty()) starts.push(item.start);
+              pending[item.start].push_back(
+                {item.start, item.rule, item.dot + 1, item.steps + cost});
+            }
+          steps[atom] = UNREACHABLE;
+        }
+        touched.clear();
+      }
+    }
+    return result;
+  }
+
+ private:
+  const std::vector<Replacement>& rules;
+  uint32_t symbols;
+  std::vector<std::vector<uint32_t>> starting_with;
+  std::vector<uint32_t> unit_rules;
+  // Atoms some rule needs after its first get a slot in waiting.
+  std::vector<uint32_t> slot_of;
+  uint32_t slots = 0;
+  // waiting[end][slot]: partial rules ending at `end` that need the slot's
+  // atom next, allocated at the first one.
+  std::vector<std::vector<std::vector<Item>>> waiting;
+  std::vector<uint32_t> steps;
+  std::vector<uint32_t> touched;
+  // cheapest[first_item[rule] + dot]: best copy of an item over one span.
+  std::vector<uint32_t> first_item;
+  std::vector<uint32_t> cheapest;
+  std::vector<Item*> distinct;
+
+  void relax(uint32_t atom, uint32_t cost) {
+    if (steps[atom] == UNREACHABLE) touched.push_back(atom);
+    if (cost < steps[atom]) steps[atom] = cost;
+  }
+
+  /* Completes or parks the cheapest copy of each item over this span. */
+  void finishItems(std::vector<Item>& items, uint32_t end, uint32_t length) {
+    for (Item& item : items) {
+      uint32_t& best = cheapest[first_item[item.rule] + item.dot];
+      if (best == UNREACHABLE) distinct.push_back(&item);
+      best = std::min(best, item.steps);
+    }
+    for (Item* item : distinct) {
+      uint32_t& best = cheapest[first_item[item->rule] + item->dot];
+      item->steps = best;
+      best = UNREACHABLE;
+      if (item->dot == rules[item->rule].to.size())
+        relax(rules[item->rule].from[0], item->steps + 1);
+      else
+        wait(*item, end, length);
+    }
+    distinct.clear();
+    items.clear();
+  }
+
+  void wait(const Item& item, uint32_t end, uint32_t length) {
+    const Molecule& to = rules[item.rule].to;
+    if (to.size() - item.dot > length - end) return;
+    if (waiting[end].empty()) waiting[end].resize(slots);
+    waiting[end][slot_of[to[item.dot]]].push_back(item);
+  }
+
+  // Each pass can only lower a cost by chaining one more unit rule.
+  void closeUnitRules() {
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (uint32_t rule : unit_rules) {
+        uint32_t cost = steps[rules[rule].to[0]];
+        uint32_t atom = rules[rule].from[0];
+        if (cost == UNREACHABLE || cost + 1 >= steps[atom]) continue;
+        relax(atom, cost + 1);
+        changed = true;
+      }
+    }
+  }
+};
+
+/* Only exact for grammars shaped like the puzzle's Rn/Y/Ar rules. */
+int closedFormSteps(const Molecule& molecule, AtomTable& atoms) {
+  uint32_t rn = atoms.tokenize("Rn")[0], ar = atoms.tokenize("Ar")[0];
+  uint32_t y = atoms.tokenize("Y")[0];
+  int steps = molecule.size() - 1;
+  for (uint32_t atom : molecule)
+    steps -= (atom == rn || atom == ar) ? 1 : (atom == y) ? 2 : 0;
+  return steps;
+}
+
+/* Builds a molecule by applying `count` random rules starting from `goal`. */
+Molecule deriveRandom(const std::vector<Replacement>& rules, uint32_t goal,
+                      size_t count, std::mt19937& rng) {
+  std::unordered_map<uint32_t, std::vector<uint32_t>> by_atom;
+  for (uint32_t rule = 0; rule < rules.size(); rule++)
+    by_atom[rules[rule].from[0]].push_back(rule);
+
+  Molecule molecule = {goal};
+  std::vector<uint32_t> positions;
+  for (size_t step = 0; step < count; step++) {
+    positions.clear();
+    for (uint32_t i = 0; i < molecule.size(); i++)
+      if (by_atom.count(molecule[i])) positions.push_back(i);
+    if (positions.empty()) break;
+    uint32_t position = positions[rng() % positions.size()];
+    const std::vector<uint32_t>& choices = by_atom[molecule[position]];
+    const Molecule& to = rules[choices[rng() % choices.size()]].to;
+    molecule.erase(molecule.begin() + position);
+    molecule.insert(molecule.begin() + position, to.begin(), to.end());
+  }
+  return molecule;
+}
+
+/* Random single-atom rules over atoms 1..symbols, unit rules included. */
+std::vector<Replacement> randomGrammar(uint32_t symbols, size_t count,
+                                       std::mt19937& rng) {
+  std::vector<Replacement> rules;
+  for (size_t i = 0; i < count; i++) {
+    Replacement rule;
+    rule.from.push_back(1 + rng() % (symbols / 2));
+    for (uint32_t length = 1 + rng() % 4; length > 0; length--)
+      rule.to.push_back(1 + rng() % symbols);
+    rules.push_back(rule);
+  }
+  return rules;
+}
+
+void benchmark(const std::vector<Replacement>& rules, AtomTable& atoms) {
+  std::mt19937 rng(19);
+  uint32_t goal = atoms.tokenize("e")[0];
+  std::vector<Replacement> generated = randomGrammar(12, 30, rng);
+
+  for (size_t count : {100, 1000, 7000}) {
+    for (bool puzzle : {true, false}) {
+      const std::vector<Replacement>& grammar = puzzle ? rules : generated;
+      uint32_t start = puzzle ? goal : 1;
+      uint32_t symbols = puzzle ? atoms.size() : 12;
+      Molecule molecule = deriveRandom(grammar, start, count, rng);
+
+      auto begin = std::chrono::steady_clock::now();
+      uint32_t steps = ReductionChart(grammar, symbols)
+                         .minimumSteps(molecule, start);
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> chart_time = end - begin;
+      std::cout << (puzzle ? "puzzle" : "random") << " derived=" << count
+                << " atoms=" << molecule.size() << " chart=" << steps;
+      if (puzzle)
+        std::cout << " closed form="
+                  << closedFormSteps(molecule, atoms);
+      std::cout << " " << chart_time.count() << "s" << std::endl;
+    }
   }
-  return count;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  bool bench = (argc >= 3) && std::string(argv[2]) == "bench";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -70,8 +329,9 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::vector<std::pair<std::string, std::string>> replacements;
-  std::string medicine_molecule;
+  AtomTable atoms;
+  std::vector<Replacement> replacements;
+  Molecule medicine_molecule;
   std::string line;
 
   while (std::getline(input_file, line)) {
@@ -79,11 +339,15 @@ int main(int argc, char* argv[]) {
       continue;
     } else if (line.find("=>") != std::string::npos) {
       size_t arrow_pos = line.find(" => ");
-      std::string from = line.substr(0, arrow_pos);
-      std::string to = line.substr(arrow_pos + 4);
+      Molecule from = atoms.tokenize(line.substr(0, arrow_pos));
+      Molecule to = atoms.tokenize(line.substr(arrow_pos + 4));
+      if (from.size() != 1 || to.empty()) {
+        std::cerr << "Error: Rules must replace one atom!" << std::endl;
+        return 1;
+      }
       replacements.push_back({from, to});
     } else {
-      medicine_molecule = line;
+      medicine_molecule = atoms.tokenize(line);
     }
   }
 
@@ -92,20 +356,21 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::regex atom_regex("([A-Z][a-z]?)");
-  std::smatch match;
-  int atom_count = 0;
-  std::string molecule = medicine_molecule;
-  while (std::regex_search(molecule, match, atom_regex)) {
-    atom_count++;
-    molecule = match.suffix();
+  if (bench) {
+    benchmark(replacements, atoms);
+    return 0;
   }
 
-  int rn_count = countOccurrences(medicine_molecule, "Rn");
-  int ar_count = countOccurrences(medicine_molecule, "Ar");
-  int y_count = countOccurrences(medicine_molecule, "Y");
-
-  int steps = atom_count - rn_count - ar_count - 2 * y_count - 1;
+  uint32_t goal = atoms.tokenize("e")[0];
+  ReductionChart chart(replacements, atoms.size());
+  uint32_t steps = chart.minimumSteps(medicine_molecule, goal);
+  if (steps == UNREACHABLE) {
+    std::cerr << "Error: The molecule can't be made from e!" << std::endl;
+    return 1;
+  }
+  if (debug)
+    std::cout << medicine_molecule.size() << " atoms, closed form: "
+              << closedFormSteps(medicine_molecule, atoms) << std::endl;
 
   int total = steps;
   std::cout << "ANSWER: " << total << std::endl;
@@ -30,14 +30,24 @@
  * The goal is to find the lowest house number that receives at least the
  * required number of presents as specified in the puzzle input.
  *
+ * The present counts are sieved in cache-sized segments with 64-bit sums, so
+ * memory stays constant however large the input is. Segments are handed out
+ * in order to a pool of threads, and the search stops at the first segment
+ * holding a match. Part 2 reuses the same sieve with a limit of 50
+ * visits per elf.
+ *
  * Puzzle Answer: [Lowest House Number]
  *
  * @author [gabrielzschmitz]
  * @date [09/09/2024]
  */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -49,6 +59,81 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
+const uint64_t NO_VISIT_LIMIT = 0;
+const uint64_t SEGMENT_SIZE = 1 << 15;
+
+/*
+ * Fills presents[i] for the houses first + i in one cache-sized segment. Every
+ * divisor pair d * q = house with d <= q is found from the small side d only,
+ * so a segment costs about SEGMENT_SIZE * ln(sqrt(last)) steps. Elf e stops
+ * after `visit_limit` houses, that is, it skips houses beyond visit_limit * e.
+ */
+void sieveSegment(uint64_t first, std::vector<uint64_t>& presents,
+                  uint64_t per_elf, uint64_t visit_limit) {
+  uint64_t last = first + presents.size() - 1;
+  std::fill(presents.begin(), presents.end(), 0);
+  for (uint64_t small = 1; small * small <= last; small++) {
+    uint64_t large = std::max(small, (first + small - 1) / small);
+    for (uint64_t house = small * large; house <= last;
+         house += small, large++) {
+      uint64_t gifts = 0;
+      if (visit_limit == NO_VISIT_LIMIT || large <= visit_limit)
+        gifts += small;
+      if (large != small && (visit_limit == NO_VISIT_LIMIT ||
+                             small <= visit_limit))
+        gifts += large;
+      presents[house - first] += gifts * per_elf;
+    }
+  }
+}
+
+/*
+ * Searches the houses segment by segment on a pool of threads, handing out
+ * segments in increasing order and stopping once a segment holds a match.
+ * Segments below a match are always finished, so the lowest house wins.
+ */
+uint64_t findLowestHouse(uint64_t target, uint64_t per_elf,
+                         uint64_t visit_limit) {
+  // House n always gets at least n * per_elf presents from elf n.
+  uint64_t limit = std::max<uint64_t>(1, (target + per_elf - 1) / per_elf);
+  uint64_t segments = (limit + SEGMENT_SIZE) / SEGMENT_SIZE;
+
+  std::atomic<uint64_t> next_segment(0);
+  std::atomic<uint64_t> found_segment(segments);
+  std::atomic<uint64_t> lowest_house(limit);
+
+  auto worker = [&]() {
+    std::vector<uint64_t> presents(SEGMENT_SIZE);
+    uint64_t segment;
+    while ((segment = next_segment++) < found_segment.load()) {
+      uint64_t first = std::max<uint64_t>(1, segment * SEGMENT_SIZE);
+      presents.resize((segment + 1) * SEGMENT_SIZE - first);
+      sieveSegment(first, presents, per_elf, visit_limit);
+      for (size_t i = 0; i < presents.size(); i++) {
+        if (presents[i] < target) continue;
+        uint64_t house = first + i;
+        uint64_t current = lowest_house.load();
+        while (house < current &&
+               !lowest_house.compare_exchange_weak(current, house)) {
+        }
+        current = found_segment.load();
+        while (segment < current &&
+               !found_segment.compare_exchange_weak(current, segment)) {
+        }
+        break;
+      }
+    }
+  };
+
+  unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < workers; i++)
+    threads.emplace_back(worker);
+  for (auto& thread : threads)
+    thread.join();
+  return lowest_house.load();
+}
+
 int main(int argc, char* argv[]) {
   std::string user_input = (argc == 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
@@ -59,28 +144,14 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  int puzzle_input;
+  uint64_t puzzle_input = 0;
   std::string line;
   while (std::getline(input_file, line))
-    puzzle_input = std::stoi(line);
+    puzzle_input = std::stoull(line);
 
   if (debug) std::cout << "input: " << puzzle_input << std::endl;
 
-  int limit = puzzle_input / 10;
-  std::vector<int> presents(limit, 0);
-
-  for (int elf = 1; elf < limit; ++elf)
-    for (int house = elf, count = 0; house < limit && count < 50;
-         house += elf, ++count)
-      presents[house] += elf * 11;
-
-  int total = 0;
-  for (int house = 1; house < limit; ++house) {
-    if (presents[house] >= puzzle_input) {
-      total = house;
-      break;
-    }
-  }
+  uint64_t total = findLowestHouse(puzzle_input, 11, 50);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
@@ -39,15 +39,24 @@
  * The program outputs the maximum amount of gold spent where the player still
  * loses.
  *
+ * Fights are decided by comparing turns-to-kill, ceil(hp / max(1, damage -
+ * armor)), instead of playing them out. Loadouts from the shop file (the
+ * `shop` next to the input, or a path given as the second argument) are built
+ * slot by slot. Hunting wins, only those no cheaper loadout matches in damage
+ * and armor are kept; hunting losses, only those no costlier one matches with
+ * as little. Both sets are then walked by cost, stopping at the cheapest win
+ * and at the costliest loss.
+ *
  * Puzzle Answer: [Maximum Gold Spent]
  *
  * @author [gabrielzschmitz]
  * @date [10/09/2024]
  */
 #include <algorithm>
-#include <climits>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -61,33 +70,243 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
+const int64_t PLAYER_HIT_POINTS = 100;
+
 struct Item {
   std::string name;
-  int cost;
-  int damage;
-  int armor;
+  int64_t cost;
+  int64_t damage;
+  int64_t armor;
+};
+
+struct Shop {
+  std::vector<Item> weapons;
+  std::vector<Item> armor;
+  std::vector<Item> rings;
 };
 
 struct Character {
-  int hit_points;
-  int damage;
-  int armor;
+  int64_t hit_points;
+  int64_t damage;
+  int64_t armor;
 };
 
-bool simulate_battle(Character player, Character boss) {
-  while (true) {
-    int player_damage_dealt = std::max(1, player.damage - boss.armor);
-    boss.hit_points -= player_damage_dealt;
-    if (boss.hit_points <= 0) { return true; }
+/* Reads "Name Cost Damage Armor" lines under Weapons:, Armor: and Rings:. */
+bool loadShop(const std::string& path, Shop& shop) {
+  std::ifstream shop_file(path);
+  if (!shop_file.is_open()) return false;
 
-    int boss_damage_dealt = std::max(1, boss.damage - player.armor);
-    player.hit_points -= boss_damage_dealt;
-    if (player.hit_points <= 0) { return false; }
+  std::vector<Item>* section = nullptr;
+  std::string line;
+  while (std::getline(shop_file, line)) {
+    std::istringstream iss(line);
+    std::vector<std::string> words;
+    for (std::string word; iss >> word;)
+      words.push_back(word);
+    if (words.empty()) continue;
+
+    if (words[0] == "Weapons:") {
+      section = &shop.weapons;
+    } else if (words[0] == "Armor:") {
+      section = &shop.armor;
+    } else if (words[0] == "Rings:") {
+      section = &shop.rings;
+    } else {
+      if (section == nullptr || words.size() < 4) return false;
+      Item item;
+      size_t stats = words.size() - 3;
+      for (size_t i = 0; i < stats; i++)
+        item.name += (i ? " " : "") + words[i];
+      item.cost = std::stoll(words[stats]);
+      item.damage = std::stoll(words[stats + 1]);
+      item.armor = std::stoll(words[stats + 2]);
+      if (item.damage < 0 || item.armor < 0) return false;
+      section->push_back(item);
+    }
   }
+  return !shop_file.bad() && !shop.weapons.empty();
+}
+
+/* The shop file sits next to the input unless one is given. */
+std::string defaultShopPath(const std::string& input) {
+  size_t pos = input.find_last_of('/');
+  std::string directory =
+    (pos == std::string::npos) ? "" : input.substr(0, pos + 1);
+  return directory + "shop";
+}
+
+int64_t turnsToKill(int64_t hit_points, int64_t damage, int64_t armor) {
+  int64_t dealt = std::max<int64_t>(1, damage - armor);
+  return (hit_points + dealt - 1) / dealt;
+}
+
+// The player strikes first, so a tie in turns is a win.
+bool playerWins(const Character& player, const Character& boss) {
+  return turnsToKill(boss.hit_points, player.damage, boss.armor) <=
+         turnsToKill(player.hit_points, boss.damage, player.armor);
+}
+
+const int64_t NO_LOADOUT = -1;
+
+/* Total cost and stats of a partial or complete loadout. */
+struct Loadout {
+  int64_t cost;
+  int64_t damage;
+  int64_t armor;
+};
+
+/*
+ * The loadouts no other one beats. Hunting the cheapest win, a loadout is
+ * beaten by one costing no more with at least its damage and armor; hunting
+ * the costliest loss, by one costing no less with at most its damage and
+ * armor. Damage saturates where the boss falls in one hit and armor where the
+ * boss is down to 1 damage. The work follows the size of the frontier, which
+ * stays small for most shops, and is bounded by the damage * armor profiles
+ * the shop can reach.
+ */
+class Frontier {
+ public:
+  Frontier(bool cheapest, int64_t max_damage, int64_t max_armor)
+    : sign(cheapest ? 1 : -1), max_damage(max_damage), max_armor(max_armor) {}
+
+  void add(int64_t cost, int64_t damage, int64_t armor) {
+    loadouts.push_back({cost, std::min(damage, max_damage),
+                        std::min(armor, max_armor)});
+  }
+
+  /* Adds every current loadout wearing `item` into `target`. */
+  void equip(const Item& item, Frontier& target) const {
+    for (const Loadout& loadout : loadouts)
+      target.add(loadout.cost + item.cost, loadout.damage + item.damage,
+                 loadout.armor + item.armor);
+  }
+
+  void merge(const Frontier& other) {
+    loadouts.insert(loadouts.end(), other.loadouts.begin(),
+                    other.loadouts.end());
+  }
+
+  /* Drops the beaten loadouts, visiting them best cost first. */
+  void prune() {
+    std::sort(loadouts.begin(), loadouts.end(),
+              [this](const Loadout& a, const Loadout& b) {
+                if (a.cost != b.cost) return sign * a.cost < sign * b.cost;
+                if (a.damage != b.damage)
+                  return sign * a.damage > sign * b.damage;
+                return sign * a.armor > sign * b.armor;
+              });
+    // Signed damage -> best signed armor kept for it or more, as a staircase
+    // where armor falls as damage rises.
+    std::map<int64_t, int64_t> staircase;
+    std::vector<Loadout> kept;
+    for (const Loadout& loadout : loadouts) {
+      int64_t damage = sign * loadout.damage, armor = sign * loadout.armor;
+      auto above = staircase.lower_bound(damage);
+      if (above != staircase.end() && above->second >= armor) continue;
+      auto step = staircase.insert_or_assign(damage, armor).first;
+      while (step != staircase.begin() && std::prev(step)->second <= armor)
+        staircase.erase(std::prev(step));
+      kept.push_back(loadout);
+    }
+    loadouts.swap(kept);
+  }
+
+  const std::vector<Loadout>& reachable() const { return loadouts; }
+
+ private:
+  int64_t sign;
+  int64_t max_damage;
+  int64_t max_armor;
+  std::vector<Loadout> loadouts;
+};
+
+int64_t largestStat(const std::vector<Item>& items, int64_t Item::*stat,
+                     size_t count) {
+  std::vector<int64_t> values;
+  for (const Item& item : items)
+    values.push_back(item.*stat);
+  std::sort(values.rbegin(), values.rend());
+  int64_t total = 0;
+  for (size_t i = 0; i < count && i < values.size(); i++)
+    total += values[i];
+  return total;
+}
+
+/* One weapon, at most one armor and at most two different rings. */
+Frontier buildFrontier(const Shop& shop, const Character& boss,
+                       bool cheapest) {
+  int64_t max_damage = largestStat(shop.weapons, &Item::damage, 1) +
+                       largestStat(shop.armor, &Item::damage, 1) +
+                       largestStat(shop.rings, &Item::damage, 2);
+  int64_t max_armor = largestStat(shop.weapons, &Item::armor, 1) +
+                      largestStat(shop.armor, &Item::armor, 1) +
+                      largestStat(shop.rings, &Item::armor, 2);
+  max_damage = std::min(max_damage, boss.armor + boss.hit_points);
+  max_armor = std::min(max_armor, std::max<int64_t>(0, boss.damage - 1));
+  // While the boss still hits for the player's whole hit points, armor never
+  // changes a fight, so a shop that can't get past that needs no armor axis.
+  if (boss.damage - max_armor >= PLAYER_HIT_POINTS) max_armor = 0;
+
+  Frontier armed(cheapest, max_damage, max_armor);
+  for (const Item& weapon : shop.weapons)
+    armed.add(weapon.cost, weapon.damage, weapon.armor);
+  armed.prune();
+
+  Frontier armored = armed;
+  for (const Item& armor : shop.armor)
+    armed.equip(armor, armored);
+  armored.prune();
+
+  // rings[n] holds the loadouts wearing n rings among those seen so far.
+  std::vector<Frontier> rings(3, Frontier(cheapest, max_damage, max_armor));
+  rings[0] = armored;
+  for (const Item& ring : shop.rings) {
+    rings[1].equip(ring, rings[2]);
+    rings[0].equip(ring, rings[1]);
+    rings[2].prune();
+    rings[1].prune();
+  }
+  rings[0].merge(rings[1]);
+  rings[0].merge(rings[2]);
+  rings[0].prune();
+  return rings[0];
+}
+
+struct Outcome {
+  int64_t cheapest_win = NO_LOADOUT;
+  int64_t costliest_loss = NO_LOADOUT;
+};
+
+/* Walks each frontier by cost from its best end, stopping at the first hit. */
+Outcome decideLoadouts(const Shop& shop, const Character& boss) {
+  Outcome outcome;
+  // Pruning leaves both frontiers sorted best cost first.
+  Frontier wins = buildFrontier(shop, boss, true);
+  for (const Loadout& loadout : wins.reachable())
+    if (playerWins({PLAYER_HIT_POINTS, loadout.damage, loadout.armor}, boss)) {
+      outcome.cheapest_win = loadout.cost;
+      break;
+    }
+
+  Frontier losses = buildFrontier(shop, boss, false);
+  for (const Loadout& loadout : losses.reachable())
+    if (!playerWins({PLAYER_HIT_POINTS, loadout.damage, loadout.armor},
+                    boss)) {
+      outcome.costliest_loss = loadout.cost;
+      break;
+    }
+
+  if (debug)
+    std::cout << wins.reachable().size() << " + "
+              << losses.reachable().size()
+              << " loadouts, cheapest win: " << outcome.cheapest_win
+              << ", costliest loss: " << outcome.costliest_loss << std::endl;
+  return outcome;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  std::string shop_path = (argc >= 3) ? argv[2] : defaultShopPath(user_input);
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -96,28 +315,17 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  // Shop items
-  std::vector<Item> weapons = {{"Dagger", 8, 4, 0},
-                               {"Shortsword", 10, 5, 0},
-                               {"Warhammer", 25, 6, 0},
-                               {"Longsword", 40, 7, 0},
-                               {"Greataxe", 74, 8, 0}};
-  std::vector<Item> armor = {
-    {"None", 0, 0, 0},        {"Leather", 13, 0, 1},
-    {"Chainmail", 31, 0, 2},  {"Splintmail", 53, 0, 3},
-    {"Bandedmail", 75, 0, 4}, {"Platemail", 102, 0, 5}};
-  std::vector<Item> rings = {
-    {"None1", 0, 0, 0},       {"None2", 0, 0, 0},
-    {"Damage +1", 25, 1, 0},  {"Damage +2", 50, 2, 0},
-    {"Damage +3", 100, 3, 0}, {"Defense +1", 20, 0, 1},
-    {"Defense +2", 40, 0, 2}, {"Defense +3", 80, 0, 3}};
-
-  Character boss;
+  Shop shop;
+  if (!loadShop(shop_path, shop)) {
+    std::cerr << "SHOP " << shop_path << " UNAVAILABLE!" << std::endl;
+    return 1;
+  }
+
+  Character boss = {0, 0, 0};
   std::string line;
   while (std::getline(input_file, line)) {
     std::istringstream iss(line);
-    std::string label;
-    int value;
+    int64_t value;
     if (line.find("Hit Points:") != std::string::npos) {
       iss.ignore(11);
       iss >> value;
@@ -133,37 +341,22 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  if (input_file.bad()) {
+    std::cerr << "Error reading the file!" << std::endl;
+    return 1;
+  }
+
   if (debug)
     std::cout << "boss stats: " << boss.hit_points << "; " << boss.damage
               << "; " << boss.armor << std::endl;
 
-  int max_cost = 0;
-
-  // Iterate over all possible combinations of 1 weapon, 0-1 armor, 0-2 rings
-  for (const auto& weapon : weapons) {
-    for (const auto& arm : armor) {
-      for (size_t i = 0; i < rings.size(); ++i) {
-        for (size_t j = i + 1; j < rings.size(); ++j) {
-          int total_cost =
-            weapon.cost + arm.cost + rings[i].cost + rings[j].cost;
-          int total_damage = weapon.damage + rings[i].damage + rings[j].damage;
-          int total_armor = arm.armor + rings[i].armor + rings[j].armor;
-
-          Character player = {100, total_damage, total_armor};
-
-          if (!simulate_battle(player, boss))
-            max_cost = std::max(max_cost, total_cost);
-        }
-      }
-    }
-  }
-
-  if (input_file.bad()) {
-    std::cerr << "Error reading the file!" << std::endl;
+  Outcome outcome = decideLoadouts(shop, boss);
+  if (outcome.costliest_loss == NO_LOADOUT) {
+    std::cerr << "Error: No loadout loses to the boss!" << std::endl;
     return 1;
   }
 
-  int total = max_cost;
+  int64_t total = outcome.costliest_loss;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
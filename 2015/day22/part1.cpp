@@ -39,6 +39,12 @@
  * The program outputs the minimum amount of mana spent where the player still
  * wins.
  *
+ * The fight state (hit points, mana, boss hit points and effect timers) is
+ * packed into a single 64-bit value and searched best-first on mana spent,
+ * guided by a lower bound on the mana still needed, with a set of already
+ * expanded states. The player's hit points and mana can be overridden with
+ * extra arguments (`part1 input <hp> <mana>`).
+ *
  * Puzzle Answer: [Minimum Mana Spent]
  *
  * @author [gabrielzschmitz]
@@ -46,13 +52,14 @@
  */
 #include <algorithm>
 #include <climits>
-#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
-#include <functional>
 #include <iostream>
-#include <limits>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -65,136 +72,204 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-struct Stat {
-  int perm = 0;
-  int temp = 0;
-  int time_left = 0;
+/* The whole fight at the start of a player turn, packed into 64 bits. */
+struct FightState {
+  uint64_t player_hp : 18;
+  uint64_t boss_hp : 18;
+  uint64_t mana : 19;
+  uint64_t shield : 3;
+  uint64_t poison : 3;
+  uint64_t recharge : 3;
 };
+static_assert(sizeof(FightState) == sizeof(uint64_t), "state must be 64 bits");
 
-enum Effects {
-  Shield,
-  Poison,
-  Recharge,
-  None,
-};
+const uint64_t MAX_MANA = (1 << 19) - 1;
+const int MAX_HIT_POINTS = (1 << 18) - 1;
 
-struct Entity {
-  Stat hp;
-  Stat damage;
-  Stat armour;
-  Stat mana;
-  std::unordered_set<Effects> effects;
-};
+uint64_t packState(const FightState& state) {
+  uint64_t key;
+  std::memcpy(&key, &state, sizeof(key));
+  return key;
+}
 
-struct Spell {
-  std::string name;
-  int cost;
-  Effects effect;
-  std::function<void(Entity&, Entity&)> function;
+struct FightRules {
+  int player_hp = 50;
+  int player_mana = 500;
+  int boss_hp = 0;
+  int boss_damage = 0;
+  bool hard_mode = false;
 };
 
-std::vector<Spell> spells{
-  {"Magic Missile", 53, Effects::None,
-   [](Entity& e1, Entity& e2) {
-     e1.mana.perm -= 53;
-     e2.hp.perm -= 4;
-   }},
-  {"Drain", 73, Effects::None,
-   [](Entity& e1, Entity& e2) {
-     e1.mana.perm -= 73;
-     e1.hp.perm += 2;
-     e2.hp.perm -= 2;
-   }},
-  {"Shield", 113, Effects::Shield,
-   [](Entity& e1, Entity& e2) {
-     e1.mana.perm -= 113;
-     e1.armour.temp = 7;
-     e1.armour.time_left = 6;
-     e1.effects.insert(Effects::Shield);
-   }},
-  {"Poison", 173, Effects::Poison,
-   [](Entity& e1, Entity& e2) {
-     e1.mana.perm -= 173;
-     e2.hp.temp = -3;
-     e2.hp.time_left = 6;
-     e2.effects.insert(Effects::Poison);
-   }},
-  {"Recharge", 229, Effects::Recharge,
-   [](Entity& e1, Entity& e2) {
-     e1.mana.perm -= 229;
-     e1.mana.temp = 101;
-     e1.mana.time_left = 5;
-     e1.effects.insert(Effects::Recharge);
-   }},
-  // {"None" , 0, [](Entity& e1, Entity& e2) { }},
-};
+enum Spell { MagicMissile, Drain, Shield, Poison, Recharge, SPELL_COUNT };
 
-int min_mana_spent = std::numeric_limits<int>::max();
-
-void resolve_effects(Entity& e) {
-  e.hp.perm += e.hp.temp;
-  e.mana.perm += e.mana.temp;
-  if (e.hp.time_left > 0) e.hp.time_left--;
-  if (e.damage.time_left > 0) e.damage.time_left--;
-  if (e.armour.time_left > 0) e.armour.time_left--;
-  if (e.mana.time_left > 0) e.mana.time_left--;
-  if (e.hp.time_left == 0) { e.effects.erase(Effects::Poison); }
-  if (e.armour.time_left == 0) { e.effects.erase(Effects::Shield); }
-  if (e.mana.time_left == 0) { e.effects.erase(Effects::Recharge); }
+const int SPELL_COST[SPELL_COUNT] = {53, 73, 113, 173, 229};
+
+/* Ticks the active effects; works on plain ints so nothing can wrap. */
+void applyEffects(int& player_armour, int& boss_hp, int& mana, int& shield,
+                  int& poison, int& recharge) {
+  player_armour = (shield > 0) ? 7 : 0;
+  if (shield > 0) shield--;
+  if (poison > 0) {
+    boss_hp -= 3;
+    poison--;
+  }
+  if (recharge > 0) {
+    mana += 101;
+    recharge--;
+  }
 }
 
-void reset_timed_out_effects(Entity& e) {
-  if (e.hp.time_left == 0) { e.hp.temp = 0; }
-  if (e.damage.time_left == 0) { e.damage.temp = 0; }
-  if (e.armour.time_left == 0) { e.armour.temp = 0; }
-  if (e.mana.time_left == 0) { e.mana.temp = 0; }
+enum Outcome { Won, Lost, Ongoing, ManaOverflow };
+
+/* True when the start of the player turn finishes the boss before a cast. */
+bool effectsWin(const FightRules& rules, const FightState& state) {
+  if (rules.hard_mode && state.player_hp <= 1) return false;
+  return (int)state.boss_hp <= (state.poison > 0 ? 3 : 0);
 }
 
-bool should_return(const Entity& player_in, const Entity& boss_in,
-                   int mana_spent) {
-  if (boss_in.hp.perm <= 0) {
-    min_mana_spent = std::min(mana_spent, min_mana_spent);
-    return true;
+/*
+ * Plays the player turn casting `spell` and then the boss turn, writing the
+ * state at the start of the next player turn into `next`. Casting a spell the
+ * player cannot afford, or one whose effect is still active, counts as lost.
+ * Callers check effectsWin first, so a win here always includes the spell.
+ * Mana that no longer fits the state after Recharge is reported, not clamped.
+ */
+Outcome playRound(const FightRules& rules, const FightState& state,
+                  Spell spell, FightState& next) {
+  int player_hp = state.player_hp, boss_hp = state.boss_hp;
+  int mana = state.mana, armour = 0;
+  int shield = state.shield, poison = state.poison;
+  int recharge = state.recharge;
+
+  if (rules.hard_mode && --player_hp <= 0) return Lost;
+  applyEffects(armour, boss_hp, mana, shield, poison, recharge);
+  if (boss_hp <= 0) return Won;
+
+  if (mana < SPELL_COST[spell]) return Lost;
+  mana -= SPELL_COST[spell];
+  switch (spell) {
+    case MagicMissile:
+      boss_hp -= 4;
+      break;
+    case Drain:
+      boss_hp -= 2;
+      player_hp += 2;
+      break;
+    case Shield:
+      if (shield > 0) return Lost;
+      shield = 6;
+      break;
+    case Poison:
+      if (poison > 0) return Lost;
+      poison = 6;
+      break;
+    case Recharge:
+      if (recharge > 0) return Lost;
+      recharge = 5;
+      break;
+    default:
+      return Lost;
   }
-  if (player_in.hp.perm <= 0) { return true; }
+  if (boss_hp <= 0) return Won;
+
+  applyEffects(armour, boss_hp, mana, shield, poison, recharge);
+  if (boss_hp <= 0) return Won;
+  player_hp -= std::max(1, rules.boss_damage - armour);
+  if (player_hp <= 0) return Lost;
+
+  next.player_hp = player_hp;
+  next.boss_hp = boss_hp;
+  if (mana > (int)MAX_MANA) return ManaOverflow;
+  next.mana = mana;
+  next.shield = shield;
+  next.poison = poison;
+  next.recharge = recharge;
+  return Ongoing;
+}
+
+/*
+ * No spell deals more damage per mana than Poison (18 for 173), so the boss's
+ * hit points not yet covered by an active Poison need at least this much mana.
+ */
+int remainingManaBound(const FightState& state) {
+  int uncovered = std::max<int>(0, state.boss_hp - 3 * state.poison);
+  return (uncovered * SPELL_COST[Poison] + 17) / 18;
+}
+
+/*
+ * States with the same boss hit points and timers are popped in order of mana
+ * spent, so one that has no more hit points and no more mana than an earlier
+ * one can never do better and is skipped. Otherwise it joins the frontier.
+ */
+bool isDominated(
+  std::unordered_map<uint64_t, std::vector<std::pair<int, int>>>& frontier,
+  const FightState& state) {
+  FightState shape = state;
+  shape.player_hp = 0;
+  shape.mana = 0;
+  std::vector<std::pair<int, int>>& seen = frontier[packState(shape)];
+  for (const auto& other : seen)
+    if (other.first >= (int)state.player_hp && other.second >= (int)state.mana)
+      return true;
+  seen.emplace_back(state.player_hp, state.mana);
   return false;
 }
 
-void fight(const Entity& player_in, const Entity& boss_in, bool player_turn,
-           int mana_spent, int level) {
-  if (mana_spent >= min_mana_spent) return;
-  if (should_return(player_in, boss_in, mana_spent)) return;
-  if (player_turn) {
-    for (const auto& spell : spells) {
-      if (player_in.mana.perm < spell.cost) continue;
-      auto player = player_in;
-      auto boss = boss_in;
-      resolve_effects(player);
-      resolve_effects(boss);
-      if (player.effects.count(spell.effect)) continue;
-      if (boss.effects.count(spell.effect)) continue;
-      if (should_return(player_in, boss_in, mana_spent)) return;
-      spell.function(player, boss);
-      reset_timed_out_effects(player);
-      reset_timed_out_effects(boss);
-      fight(player, boss, false, mana_spent + spell.cost, level + 1);
+/*
+ * Best-first search on mana spent over fight states, ordered by mana spent
+ * plus remainingManaBound (Dijkstra steered towards the boss). Every state is
+ * expanded at most once, and the search ends as soon as no queued state can
+ * beat the cheapest win found. Returns INT_MAX when the boss cannot be beaten,
+ * and sets `overflowed` if a fight that could still have been cheaper gathered
+ * more mana than a state holds.
+ */
+int findMinimumMana(const FightRules& rules, bool& overflowed) {
+  typedef std::pair<int, uint64_t> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  std::unordered_set<uint64_t> expanded;
+  std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> frontier;
+
+  FightState start = {};
+  start.player_hp = rules.player_hp;
+  start.boss_hp = rules.boss_hp;
+  start.mana = rules.player_mana;
+  queue.push({remainingManaBound(start), packState(start)});
+
+  int min_mana_spent = INT_MAX, overflow_spent = INT_MAX;
+  while (!queue.empty()) {
+    Entry entry = queue.top();
+    queue.pop();
+    if (entry.first >= min_mana_spent) break;
+    if (!expanded.insert(entry.second).second) continue;
+
+    FightState state;
+    std::memcpy(&state, &entry.second, sizeof(state));
+    if (isDominated(frontier, state)) continue;
+    int spent_so_far = entry.first - remainingManaBound(state);
+    if (effectsWin(rules, state)) {
+      min_mana_spent = spent_so_far;
+      continue;
+    }
+    for (int spell = 0; spell < SPELL_COUNT; spell++) {
+      FightState next;
+      int spent = spent_so_far + SPELL_COST[spell];
+      if (spent >= min_mana_spent) continue;
+      Outcome outcome = playRound(rules, state, Spell(spell), next);
+      if (outcome == ManaOverflow)
+        overflow_spent = std::min(overflow_spent, spent);
+      if (outcome == Won) min_mana_spent = spent;
+      else if (outcome == Ongoing && !expanded.count(packState(next)))
+        queue.push({spent + remainingManaBound(next), packState(next)});
     }
-  } else {
-    auto player = player_in;
-    auto boss = boss_in;
-    resolve_effects(player);
-    resolve_effects(boss);
-    if (should_return(player_in, boss_in, mana_spent)) return;
-    player.hp.perm -=
-      std::max(1, boss.damage.perm - player.armour.perm - player.armour.temp);
-    reset_timed_out_effects(boss);
-    reset_timed_out_effects(player);
-    fight(player, boss, true, mana_spent, level + 1);
   }
+
+  overflowed = overflow_spent < min_mana_spent;
+  if (debug) std::cout << "states expanded: " << expanded.size() << std::endl;
+  return min_mana_spent;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -203,38 +278,62 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  Entity enemy;
+  FightRules rules;
+  rules.hard_mode = false;
+  if (argc >= 4) {
+    rules.player_hp = std::stoi(argv[2]);
+    rules.player_mana = std::stoi(argv[3]);
+  }
+
   std::string line;
   while (std::getline(input_file, line)) {
     std::istringstream iss(line);
-    std::string label;
     int value;
     if (line.find("Hit Points:") != std::string::npos) {
       iss.ignore(11);
       iss >> value;
-      enemy.hp.perm = value;
+      rules.boss_hp = value;
     } else if (line.find("Damage:") != std::string::npos) {
       iss.ignore(8);
       iss >> value;
-      enemy.damage.perm = value;
+      rules.boss_damage = value;
     }
   }
 
-  Entity player;
-  player.hp.perm = 50;
-  player.mana.perm = 500;
+  if (rules.player_mana < 0 || rules.player_mana > (int)MAX_MANA) {
+    std::cerr << "Error: Mana must be between 0 and " << MAX_MANA << "!"
+              << std::endl;
+    return 1;
+  }
+  if (rules.player_hp < 1 || rules.player_hp > MAX_HIT_POINTS ||
+      rules.boss_hp < 1 || rules.boss_hp > MAX_HIT_POINTS) {
+    std::cerr << "Error: Hit points must be between 1 and " << MAX_HIT_POINTS
+              << "!" << std::endl;
+    return 1;
+  }
 
   if (debug)
-    std::cout << "boss stats: " << enemy.hp.perm << "; " << enemy.damage.perm
+    std::cout << "boss stats: " << rules.boss_hp << "; " << rules.boss_damage
               << std::endl;
 
-  fight(player, enemy, true, 0, 1);
+  bool overflowed = false;
+  int min_mana_spent = findMinimumMana(rules, overflowed);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
 
+  if (overflowed) {
+    std::cerr << "Error: Mana grew past " << MAX_MANA << " during the fight!"
+              << std::endl;
+    return 1;
+  }
+  if (min_mana_spent == INT_MAX) {
+    std::cerr << "Error: The boss can't be beaten!" << std::endl;
+    return 1;
+  }
+
   int total = min_mana_spent;
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
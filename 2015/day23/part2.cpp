@@ -31,6 +31,10 @@
  * The task is to execute the input program with this modified starting
  * condition and determine the final value in register `b`.
  *
+ * The program is decoded once into compact instructions with absolute jump
+ * targets and run with threaded dispatch on 64-bit registers. The Collatz
+ * counting loop found in the puzzle input is recognized and run natively.
+ *
  * Puzzle Answer: [Final Value of b]
  *
  * @author [gabrielzschmitz]
@@ -41,7 +45,6 @@
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 bool debug = false;
@@ -53,64 +56,134 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-uint32_t simulateProgram(const std::vector<std::string>& instructions,
-                         const int initialA) {
-  std::unordered_map<std::string, uint32_t> registers = {{"a", initialA},
-                                                         {"b", 0}};
-  int ip = 0;
+enum Opcode : uint8_t { Hlf, Tpl, Inc, Jmp, Jie, Jio, Collatz, Halt };
 
-  while (ip >= 0 && ip < instructions.size()) {
-    std::string inst = instructions[ip];
-    std::stringstream ss(inst);
-    std::string command, reg;
-    int offset;
+/* One decoded instruction; jump targets are absolute and never out of range. */
+struct Instruction {
+  Opcode opcode;
+  uint8_t reg;
+  uint8_t counter;
+  int32_t target;
+};
 
-    ss >> command;
+const int REGISTER_COUNT = 26;
+const int COLLATZ_LENGTH = 8;
 
-    if (command == "hlf") {
-      ss >> reg;
-      registers[reg] /= 2;
-      ip++;
-    } else if (command == "tpl") {
-      ss >> reg;
-      registers[reg] *= 3;
-      ip++;
-    } else if (command == "inc") {
-      ss >> reg;
-      registers[reg]++;
-      ip++;
-    } else if (command == "jmp") {
-      ss >> offset;
-      ip += offset;
-    } else if (command == "jie") {
-      ss >> reg >> offset;
-      reg.pop_back();
-      if (registers[reg] % 2 == 0) {
-        ip += offset;
-      } else {
-        ip++;
-      }
-    } else if (command == "jio") {
-      ss >> reg >> offset;
-      reg.pop_back();
-      if (registers[reg] == 1) {
-        ip += offset;
-      } else {
-        ip++;
-      }
+bool matches(const std::vector<Instruction>& program, size_t at, Opcode opcode,
+             int reg, int target) {
+  return at < program.size() && program[at].opcode == opcode &&
+         program[at].reg == reg && program[at].target == target;
+}
+
+/*
+ * Recognizes the loop that counts Collatz steps of register x in register y:
+ *   jio x, +8 / inc y / jie x, +4 / tpl x / inc x / jmp +2 / hlf x / jmp -7
+ * Only the head is replaced, so jumps into the body still behave the same.
+ */
+void fuseCollatzLoops(std::vector<Instruction>& program) {
+  for (size_t at = 0; at + COLLATZ_LENGTH <= program.size(); at++) {
+    int x = program[at].reg, y = program[at + 1].reg;
+    int exit = at + COLLATZ_LENGTH, head = at;
+    if (program[at].opcode == Jio && program[at].target == exit &&
+        matches(program, at + 1, Inc, y, at + 2) && x != y &&
+        matches(program, at + 2, Jie, x, at + 6) &&
+        matches(program, at + 3, Tpl, x, at + 4) &&
+        matches(program, at + 4, Inc, x, at + 5) &&
+        matches(program, at + 5, Jmp, 0, at + 7) &&
+        matches(program, at + 6, Hlf, x, at + 7) &&
+        matches(program, at + 7, Jmp, 0, head)) {
+      program[at].opcode = Collatz;
+      program[at].counter = y;
+      if (debug) std::cout << "collatz loop at " << at << std::endl;
     }
+  }
+}
 
-    if (debug) {
-      std::cout << "Executed: " << inst << " | a: " << registers["a"]
-                << ", b: " << registers["b"] << std::endl;
+/*
+ * Parses every line once; unknown lines and a final sentinel decode to Halt.
+ */
+std::vector<Instruction> decodeProgram(const std::vector<std::string>& lines) {
+  int size = lines.size();
+  std::vector<Instruction> program;
+  for (int ip = 0; ip < size; ip++) {
+    std::stringstream ss(lines[ip]);
+    std::string command, reg;
+    int offset = 1;
+    ss >> command;
+
+    Instruction instruction = {Halt, 0, 0, ip + 1};
+    if (command == "jmp") {
+      instruction.opcode = Jmp;
+      ss >> offset;
+    } else {
+      ss >> reg;
+      if (reg.empty() || reg[0] < 'a' || reg[0] > 'z') command.clear();
+      else instruction.reg = reg[0] - 'a';
+      if (command == "hlf") instruction.opcode = Hlf;
+      else if (command == "tpl") instruction.opcode = Tpl;
+      else if (command == "inc") instruction.opcode = Inc;
+      else if (command == "jie") instruction.opcode = Jie;
+      else if (command == "jio") instruction.opcode = Jio;
+      if (instruction.opcode == Jie || instruction.opcode == Jio) ss >> offset;
     }
+    long long target = (long long)ip + offset;
+    instruction.target = (target < 0 || target > size) ? size : target;
+    program.push_back(instruction);
   }
+  program.push_back({Halt, 0, 0, size});
+  fuseCollatzLoops(program);
+  return program;
+}
+
+/* Runs the program with threaded dispatch: each handler jumps to the next. */
+void runProgram(const std::vector<Instruction>& program,
+                uint64_t (&registers)[REGISTER_COUNT]) {
+  static const void* handlers[] = {&&hlf, &&tpl, &&inc,     &&jmp,
+                                   &&jie, &&jio, &&collatz, &&halt};
+  const Instruction* code = program.data();
+  const Instruction* ip = code;
+#define DISPATCH() goto* handlers[ip->opcode]
+#define NEXT() goto* handlers[(++ip)->opcode]
 
-  return registers["b"];
+  DISPATCH();
+hlf:
+  registers[ip->reg] /= 2;
+  NEXT();
+tpl:
+  registers[ip->reg] *= 3;
+  NEXT();
+inc:
+  registers[ip->reg]++;
+  NEXT();
+jmp:
+  ip = code + ip->target;
+  DISPATCH();
+jie:
+  ip = (registers[ip->reg] % 2 == 0) ? code + ip->target : ip + 1;
+  DISPATCH();
+jio:
+  ip = (registers[ip->reg] == 1) ? code + ip->target : ip + 1;
+  DISPATCH();
+collatz : {
+  uint64_t value = registers[ip->reg];
+  uint64_t steps = 0;
+  while (value != 1) {
+    value = (value % 2 == 0) ? value / 2 : 3 * value + 1;
+    steps++;
+  }
+  registers[ip->reg] = value;
+  registers[ip->counter] += steps;
+  ip = code + ip->target;
+  DISPATCH();
+}
+halt:
+  return;
+#undef NEXT
+#undef DISPATCH
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -130,7 +203,13 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  uint32_t total = simulateProgram(instructions, 1);
+  std::vector<Instruction> program = decodeProgram(instructions);
+  uint64_t registers[REGISTER_COUNT] = {1, 0};
+  runProgram(program, registers);
+  if (debug)
+    std::cout << "a: " << registers[0] << ", b: " << registers[1] << std::endl;
+
+  uint64_t total = registers[1];
   std::cout << "ANSWER: " << total << std::endl;
   return 0;
 }
@@ -29,6 +29,12 @@
  * and calculates the quantum entanglement of the ideal first group that
  * balances the sleigh in four equal parts.
  *
+ * Packages are handled as 64-bit masks. First groups are found meet-in-the-
+ * middle for each size in increasing order and checked by lowest entanglement
+ * first, so the search stops at the first group whose leftovers still split.
+ * Entanglements are exact products, so they never overflow.
+ * The group count can be passed as a second argument.
+ *
  * Puzzle Answer: [Quantum Entanglement of Ideal First Group]
  *
  * @author [gabrielzschmitz]
@@ -37,8 +43,12 @@
 #include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <queue>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 bool debug = false;
@@ -50,43 +60,239 @@ void checkDebugFlag(const std::string& input, bool& debug) {
   if (last_part == "test") debug = true;
 }
 
-void findCombinations(const std::vector<int32_t>& weights,
-                      int32_t current_weight, std::vector<int32_t>& combination,
-                      int32_t idx, int32_t target_weight,
-                      std::vector<std::vector<int32_t>>& combinations) {
-  for (int32_t i = idx; i < weights.size(); i++) {
-    if (current_weight + weights[i] < target_weight) {
-      combination.push_back(weights[i]);
-      findCombinations(weights, current_weight + weights[i], combination, i + 1,
-                       target_weight, combinations);
-      combination.pop_back();
-    } else if (current_weight + weights[i] == target_weight) {
-      combination.push_back(weights[i]);
-      combinations.push_back(combination);
-      combination.pop_back();
+const int MAX_PACKAGES = 64;
+const size_t CANDIDATE_LIMIT = 1 << 16;
+
+/* Exact product of package weights, kept as little-endian 64-bit limbs. */
+struct Entanglement {
+  std::vector<uint64_t> limbs;
+
+  bool operator<(const Entanglement& other) const {
+    if (limbs.size() != other.limbs.size())
+      return limbs.size() < other.limbs.size();
+    return std::lexicographical_compare(limbs.rbegin(), limbs.rend(),
+                                        other.limbs.rbegin(),
+                                        other.limbs.rend());
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, Entanglement value) {
+  std::string digits;
+  while (!value.limbs.empty()) {
+    unsigned __int128 remainder = 0;
+    for (size_t i = value.limbs.size(); i-- > 0;) {
+      remainder = (remainder << 64) | value.limbs[i];
+      value.limbs[i] = (uint64_t)(remainder / 10);
+      remainder %= 10;
     }
+    while (!value.limbs.empty() && value.limbs.back() == 0)
+      value.limbs.pop_back();
+    digits.push_back('0' + (int)remainder);
   }
+  if (digits.empty()) digits = "0";
+  std::reverse(digits.begin(), digits.end());
+  return out << digits;
 }
 
-bool hasOverlap(const std::vector<int32_t>& v1,
-                const std::vector<int32_t>& v2) {
-  for (const auto& ele_v1 : v1) {
-    if (std::find(v2.begin(), v2.end(), ele_v1) != v2.end()) { return true; }
+typedef std::pair<Entanglement, uint64_t> Candidate;  // {entanglement, mask}
+
+/* Exact product of the weights in mask, however many bits it needs. */
+Entanglement calculateQuantumEntanglement(const std::vector<int64_t>& weights,
+                                          uint64_t mask) {
+  Entanglement product;
+  product.limbs.push_back(1);
+  for (; mask; mask &= mask - 1) {
+    uint64_t weight = weights[__builtin_ctzll(mask)];
+    if (weight == 0) product.limbs.clear();
+    unsigned __int128 carry = 0;
+    for (uint64_t& limb : product.limbs) {
+      carry += (unsigned __int128)limb * weight;
+      limb = (uint64_t)carry;
+      carry >>= 64;
+    }
+    if (carry) product.limbs.push_back((uint64_t)carry);
   }
-  return false;
+  return product;
 }
 
-uint64_t calculateQuantumEntanglement(const std::vector<int32_t>& combination) {
-  uint64_t product = 1;
-  for (const auto& weight : combination) {
-    product *= weight;
+/* Keeps the CANDIDATE_LIMIT candidates with the smallest entanglement. */
+struct CandidateHeap {
+  std::priority_queue<Candidate> heap;
+  Candidate after;
+  bool has_after = false;
+  bool overflowed = false;
+
+  void offer(const Candidate& candidate) {
+    if (has_after && candidate <= after) return;
+    if (heap.size() == CANDIDATE_LIMIT) {
+      if (candidate >= heap.top()) {
+        overflowed = true;
+        return;
+      }
+      heap.pop();
+      overflowed = true;
+    }
+    heap.push(candidate);
   }
-  return product;
+};
+
+/* Calls visit(mask, sum, count) for every subset of [from, to) up to size. */
+template <typename Visit>
+void enumerateSubsets(const std::vector<int64_t>& weights, int from, int to,
+                      int size, int64_t limit, uint64_t mask, int64_t sum,
+                      int count, Visit& visit) {
+  visit(mask, sum, count);
+  if (count == size) return;
+  for (int i = from; i < to; i++)
+    if (sum + weights[i] <= limit)
+      enumerateSubsets(weights, i + 1, to, size, limit, mask | (1ULL << i),
+                       sum + weights[i], count + 1, visit);
+}
+
+/*
+ * Finds every group of exactly `size` packages weighing `target` by meeting in
+ * the middle: subsets of the second half are indexed by (size, weight) and
+ * matched against subsets of the first half, whose enumeration is split by
+ * its first package across threads.
+ */
+void findGroups(const std::vector<int64_t>& weights, int size, int64_t target,
+                CandidateHeap& candidates) {
+  int n = weights.size(), middle = n / 2;
+  std::unordered_map<uint64_t, std::vector<uint64_t>> right;
+  auto index = [&](uint64_t mask, int64_t sum, int count) {
+    right[(uint64_t)sum * (MAX_PACKAGES + 1) + count].push_back(mask);
+  };
+  enumerateSubsets(weights, middle, n, size, target, 0, 0, 0, index);
+
+  unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<CandidateHeap> heaps(workers, candidates);
+  std::vector<std::thread> threads;
+  for (unsigned worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      auto match = [&](uint64_t mask, int64_t sum, int count) {
+        auto found = right.find((uint64_t)(target - sum) * (MAX_PACKAGES + 1) +
+                                (size - count));
+        if (found == right.end()) return;
+        for (uint64_t other : found->second) {
+          uint64_t group = mask | other;
+          heaps[worker].offer(
+            {calculateQuantumEntanglement(weights, group), group});
+        }
+      };
+      if (worker == 0) match(0, 0, 0);
+      for (int first = worker; first < middle; first += workers)
+        if (weights[first] <= target)
+          enumerateSubsets(weights, first + 1, middle, size, target,
+                           1ULL << first, weights[first], 1, match);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (auto& heap : heaps) {
+    candidates.overflowed |= heap.overflowed;
+    for (; !heap.heap.empty(); heap.heap.pop())
+      candidates.offer(heap.heap.top());
+  }
+}
+
+/* Bitset subset-sum: can some of the packages in mask weigh exactly target? */
+bool hasSubsetSum(const std::vector<int64_t>& weights, uint64_t mask,
+                  int64_t target) {
+  std::vector<uint64_t> reachable(target / 64 + 1, 0);
+  reachable[0] = 1;
+  for (; mask; mask &= mask - 1) {
+    int64_t shift = weights[__builtin_ctzll(mask)];
+    if (shift > target) continue;
+    int64_t words = shift / 64, bits = shift % 64;
+    for (int64_t i = reachable.size() - 1; i >= words; i--) {
+      uint64_t moved = reachable[i - words] << bits;
+      if (bits && i - words - 1 >= 0)
+        moved |= reachable[i - words - 1] >> (64 - bits);
+      reachable[i] |= moved;
+    }
+  }
+  return (reachable[target / 64] >> (target % 64)) & 1;
+}
+
+/* Whether the packages in mask split into `groups` groups weighing target. */
+bool canSplit(const std::vector<int64_t>& weights, uint64_t mask, int groups,
+              int64_t target) {
+  if (groups <= 1) return true;
+  if (!hasSubsetSum(weights, mask, target)) return false;
+  if (groups == 2) return true;
+
+  // The lightest-index package has to go somewhere; try every group with it.
+  int first = __builtin_ctzll(mask);
+  uint64_t rest = mask & (mask - 1);
+  bool found = false;
+  std::function<void(uint64_t, uint64_t, int64_t)> grow =
+    [&](uint64_t group, uint64_t options, int64_t sum) {
+      if (found) return;
+      if (sum == target) {
+        found = canSplit(weights, mask & ~group, groups - 1, target);
+        return;
+      }
+      for (; options && !found; options &= options - 1) {
+        int i = __builtin_ctzll(options);
+        if (sum + weights[i] <= target)
+          grow(group | (1ULL << i), options & (options - 1), sum + weights[i]);
+      }
+    };
+  grow(1ULL << first, rest, weights[first]);
+  return found;
+}
+
+/*
+ * Tries first-group sizes in increasing order. For each size the matching
+ * groups are visited by increasing entanglement in bounded batches, and the
+ * first one whose leftovers split into the other groups is the answer.
+ */
+Entanglement findIdealEntanglement(const std::vector<int64_t>& weights,
+                                   int groups) {
+  int64_t total_weight = 0;
+  for (int64_t weight : weights)
+    total_weight += weight;
+  if (groups <= 0 || weights.size() > MAX_PACKAGES ||
+      total_weight % groups != 0)
+    return Entanglement();
+  int64_t target = total_weight / groups;
+  uint64_t all = (weights.size() == MAX_PACKAGES)
+                   ? ~0ULL
+                   : (1ULL << weights.size()) - 1;
+
+  for (size_t size = 1; size <= weights.size(); size++) {
+    CandidateHeap candidates;
+    do {
+      candidates.overflowed = false;
+      findGroups(weights, size, target, candidates);
+      std::vector<Candidate> batch;
+      for (; !candidates.heap.empty(); candidates.heap.pop())
+        batch.push_back(candidates.heap.top());
+      std::reverse(batch.begin(), batch.end());
+      if (debug && !batch.empty())
+        std::cout << "size " << size << ": " << batch.size() << " groups"
+                  << std::endl;
+
+      for (const Candidate& candidate : batch)
+        if (canSplit(weights, all & ~candidate.second, groups - 1, target))
+          return candidate.first;
+      if (!batch.empty()) {
+        candidates.after = batch.back();
+        candidates.has_after = true;
+      }
+    } while (candidates.overflowed);
+  }
+  return Entanglement();
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
+  int groups = (argc >= 3) ? std::stoi(argv[2]) : 4;
   checkDebugFlag(user_input, debug);
+  if (groups < 1) {
+    std::cerr << "Error: There must be at least one group." << std::endl;
+    return 1;
+  }
 
   std::ifstream input_file(user_input);
   if (!input_file.is_open()) {
@@ -95,57 +301,26 @@ int main(int argc, char* argv[]) {
   }
 
   std::string line;
-  std::vector<int32_t> weights;
-  int32_t total_weight = 0;
+  std::vector<int64_t> weights;
+  int64_t total_weight = 0;
   while (std::getline(input_file, line)) {
-    int32_t weight = std::stoi(line);
+    int64_t weight = std::stoll(line);
     total_weight += weight;
     weights.push_back(weight);
   }
 
-  if (total_weight % 4 != 0) {
-    std::cerr << "Error: Packages cannot be split into four equal groups."
-              << std::endl;
+  if (total_weight % groups != 0) {
+    std::cerr << "Error: Packages cannot be split into " << groups
+              << " equal groups." << std::endl;
     return 1;
   }
-  int32_t target_weight = total_weight / 4;
-
-  std::vector<std::vector<int32_t>> valid_combinations;
-  {
-    std::vector<int32_t> current_combination;
-    findCombinations(weights, 0, current_combination, 0, target_weight,
-                     valid_combinations);
+  if (weights.size() > MAX_PACKAGES) {
+    std::cerr << "Error: At most " << MAX_PACKAGES << " packages supported."
+              << std::endl;
+    return 1;
   }
 
-  std::sort(valid_combinations.begin(), valid_combinations.end(),
-            [](const std::vector<int32_t>& c1, const std::vector<int32_t>& c2) {
-              if (c1.size() != c2.size()) return c1.size() < c2.size();
-              return calculateQuantumEntanglement(c1) <
-                     calculateQuantumEntanglement(c2);
-            });
-
-  uint64_t total = 0;
-  for (int32_t i = 0; i < valid_combinations.size(); ++i) {
-    if (total != 0) break;
-    for (int32_t j = i + 1; j < valid_combinations.size(); ++j) {
-      if (hasOverlap(valid_combinations[i], valid_combinations[j])) continue;
-      for (int32_t k = j + 1; k < valid_combinations.size(); ++k) {
-        if (hasOverlap(valid_combinations[i], valid_combinations[k]) ||
-            hasOverlap(valid_combinations[j], valid_combinations[k]))
-          continue;
-        for (int32_t l = k + 1; l < valid_combinations.size(); ++l) {
-          if (!hasOverlap(valid_combinations[i], valid_combinations[l]) &&
-              !hasOverlap(valid_combinations[j], valid_combinations[l]) &&
-              !hasOverlap(valid_combinations[k], valid_combinations[l])) {
-            total = calculateQuantumEntanglement(valid_combinations[i]);
-            break;
-          }
-        }
-        if (total != 0) break;
-      }
-      if (total != 0) break;
-    }
-  }
+  Entanglement total = findIdealEntanglement(weights, groups);
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
@@ -31,6 +31,10 @@
  * The program processes the row and column input, computes the sequence number
  * in the diagonal order, and then calculates the corresponding code.
  *
+ * Codes are computed directly as START_CODE * MULTIPLIER^(n - 1) by square-and-
+ * multiply in Montgomery form. A file of "row col" lines is answered in batch
+ * across threads, printing one code per query before the last one's answer.
+ *
  * Puzzle Answer: [Code at Given Location]
  *
  * @author [gabrielzschmitz]
@@ -38,9 +42,11 @@
  */
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 bool debug = false;
@@ -56,7 +62,7 @@ const uint64_t START_CODE = 20151125;
 const uint64_t MULTIPLIER = 252533;
 const uint64_t MODULO = 33554393;
 
-uint64_t calculateSequenceNumber(int row, int col) {
+uint64_t calculateSequenceNumber(uint64_t row, uint64_t col) {
   uint64_t diagonal = row + col - 1;
 
   uint64_t sequence_number = (diagonal * (diagonal - 1)) / 2 + col;
@@ -64,17 +70,89 @@ uint64_t calculateSequenceNumber(int row, int col) {
   return sequence_number;
 }
 
+/*
+ * Montgomery arithmetic modulo an odd modulus below 2^32 with R = 2^32, so a
+ * modular product costs two multiplications and a shift instead of a division.
+ */
+class Montgomery {
+ public:
+  explicit Montgomery(uint32_t modulus) : modulus(modulus), inverse(1) {
+    // Newton's iteration doubles the correct low bits of -1/modulus each step.
+    for (int i = 0; i < 5; i++)
+      inverse *= 2 - modulus * inverse;
+    inverse = -inverse;
+    r_squared = (uint32_t)((((unsigned __int128)1 << 64)) % modulus);
+  }
+
+  uint32_t toMontgomery(uint32_t value) const {
+    return multiply(value % modulus, r_squared);
+  }
+  uint32_t fromMontgomery(uint32_t value) const { return reduce(value); }
+
+  uint32_t multiply(uint32_t a, uint32_t b) const {
+    return reduce((uint64_t)a * b);
+  }
+
+  /* base^exponent, with base and result in Montgomery form. */
+  uint32_t power(uint32_t base, uint64_t exponent) const {
+    uint32_t result = toMontgomery(1);
+    for (; exponent; exponent >>= 1) {
+      if (exponent & 1) result = multiply(result, base);
+      base = multiply(base, base);
+    }
+    return result;
+  }
+
+ private:
+  uint32_t modulus;
+  uint32_t inverse;
+  uint32_t r_squared;
+
+  uint32_t reduce(uint64_t value) const {
+    uint32_t m = (uint32_t)value * inverse;
+    uint64_t reduced = (value + (uint64_t)m * modulus) >> 32;
+    return (reduced >= modulus) ? reduced - modulus : reduced;
+  }
+};
+
+const Montgomery CODE_FIELD(MODULO);
+const uint32_t START_CODE_FORM = CODE_FIELD.toMontgomery(START_CODE);
+const uint32_t MULTIPLIER_FORM = CODE_FIELD.toMontgomery(MULTIPLIER);
+
 uint64_t generateCode(uint64_t sequence_number) {
-  uint64_t code = START_CODE;
+  // MODULO is prime, so by Fermat the exponent only matters mod MODULO - 1.
+  uint32_t steps =
+    CODE_FIELD.power(MULTIPLIER_FORM, (sequence_number - 1) % (MODULO - 1));
+  return CODE_FIELD.fromMontgomery(CODE_FIELD.multiply(START_CODE_FORM, steps));
+}
 
-  for (uint64_t i = 1; i < sequence_number; ++i)
-    code = (code * MULTIPLIER) % MODULO;
+struct Query {
+  uint64_t row;
+  uint64_t col;
+};
 
-  return code;
+/* Answers every query, splitting them into contiguous chunks across threads. */
+std::vector<uint64_t> generateCodes(const std::vector<Query>& queries) {
+  std::vector<uint64_t> codes(queries.size());
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, queries.size() / 4096 + 1);
+  size_t chunk = (queries.size() + workers - 1) / workers;
+
+  std::vector<std::thread> threads;
+  for (size_t worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      size_t end = std::min(queries.size(), (worker + 1) * chunk);
+      for (size_t i = worker * chunk; i < end; i++)
+        codes[i] = generateCode(
+          calculateSequenceNumber(queries[i].row, queries[i].col));
+    });
+  for (auto& thread : threads)
+    thread.join();
+  return codes;
 }
 
 int main(int argc, char* argv[]) {
-  std::string user_input = (argc == 2) ? argv[1] : "input";
+  std::string user_input = (argc >= 2) ? argv[1] : "input";
   checkDebugFlag(user_input, debug);
 
   std::ifstream input_file(user_input);
@@ -83,22 +161,45 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  // Either the puzzle's "row:"/"column:" lines or one "row col" pair a line.
   std::string line;
-  int row = 0, col = 0;
+  std::vector<Query> queries;
+  uint64_t row = 0, col = 0;
   while (std::getline(input_file, line)) {
-    if (line.find("row:") != std::string::npos)
-      row = std::stoi(line.substr(line.find(":") + 1));
-    else if (line.find("column:") != std::string::npos)
-      col = std::stoi(line.substr(line.find(":") + 1));
+    if (line.find("row:") != std::string::npos) {
+      row = std::stoull(line.substr(line.find(":") + 1));
+    } else if (line.find("column:") != std::string::npos) {
+      col = std::stoull(line.substr(line.find(":") + 1));
+    } else {
+      char* end;
+      row = std::strtoull(line.c_str(), &end, 10);
+      col = std::strtoull(end, &end, 10);
+    }
+    if (row != 0 && col != 0) {
+      queries.push_back({row, col});
+      row = col = 0;
+    }
   }
 
   if (input_file.bad()) {
     std::cerr << "Error reading the file!" << std::endl;
     return 1;
   }
+  if (queries.empty()) {
+    std::cerr << "Error: No row and column given!" << std::endl;
+    return 1;
+  }
 
-  uint64_t sequence_number = calculateSequenceNumber(row, col);
-  uint64_t code = generateCode(sequence_number);
+  std::vector<uint64_t> codes = generateCodes(queries);
+  if (queries.size() > 1) {
+    std::string output;
+    for (size_t i = 0; i < codes.size(); i++)
+      output += std::to_string(queries[i].row) + " " +
+                std::to_string(queries[i].col) + ": " +
+                std::to_string(codes[i]) + "\n";
+    std::cout << output;
+  }
+  uint64_t code = codes.back();
 
   uint64_t total = code;
   std::cout << "ANSWER: " << total << std::endl;
@@ -27,67 +27,269 @@
  * both numeric digits and numbers represented in words.
  * If the input file is inaccessible, an error message is displayed.
  *
- * The program utilizes a map to associate numeric values with their word
- * representations for conversion.
+ * The digit words and digits are compiled into an Aho-Corasick automaton with
+ * a full transition table, plus a second one over the reversed words. Each
+ * line is scanned forward up to its first match and backward from its end up
+ * to its last match. The mapped input is split into line-aligned chunks that
+ * are summed in parallel. Running `part2 input bench` times the scanner on a
+ * synthetic calibration document.
  *
  * @author [gabrielzschmitz]
  * @date [01/12/2023]
  */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
-#include <fstream>
 #include <iostream>
-#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 using namespace std;
 
-map<unsigned int, string> numbers = {
-  {0, "zero"}, {1, "one"}, {2, "two"},   {3, "three"}, {4, "four"},
-  {5, "five"}, {6, "six"}, {7, "seven"}, {8, "eight"}, {9, "nine"}};
-int convert_line_to_int(int total, const string& line);
+const string numbers[] = {"zero", "one", "two",   "three", "four",
+                          "five", "six", "seven", "eight", "nine"};
+
+class MappedFile {
+ public:
+  explicit MappedFile(const string& path) : bytes(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+      if (info.st_size > 0) {
+        void* mapped =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          bytes = static_cast<const char*>(mapped);
+          length = info.st_size;
+        }
+      }
+      // An empty file is open with nothing mapped; a failed mapping is not.
+      opened = info.st_size == 0 || bytes != nullptr;
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool is_open() const { return opened; }
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+ private:
+  const char* bytes;
+  size_t length;
+  bool opened = false;
+};
+
+/*
+ * Aho-Corasick automaton over the digit words and the digits themselves, with
+ * the failure links folded into a full 256-way transition table. No pattern
+ * contains another, so each state reports at most one digit. The reversed
+ * automaton matches the words spelled backwards, for scanning from line ends.
+ */
+class DigitAutomaton {
+ public:
+  explicit DigitAutomaton(bool reversed) {
+    add_state();
+    for (int digit = 0; digit <= 9; digit++) {
+      string word = numbers[digit];
+      if (reversed) reverse(word.begin(), word.end());
+      add_pattern(word, digit);
+      add_pattern(string(1, '0' + digit), digit);
+    }
+    compile();
+  }
+
+  // First digit whose pattern ends in [begin, end), or -1.
+  int scan_forward(const char* begin, const char* end) const {
+    const uint16_t* table = moves.data();
+    uint16_t offset = 0;
+    for (const char* it = begin; it != end; ++it) {
+      offset = table[offset | static_cast<uint8_t>(*it)];
+      if (offset & MATCHED) return offset & ~MATCHED;
+    }
+    return -1;
+  }
+
+  // Same, reading [begin, end) from the back; used on the reversed words.
+  int scan_backward(const char* begin, const char* end) const {
+    const uint16_t* table = moves.data();
+    uint16_t offset = 0;
+    for (const char* it = end; it != begin;) {
+      offset = table[offset | static_cast<uint8_t>(*--it)];
+      if (offset & MATCHED) return offset & ~MATCHED;
+    }
+    return -1;
+  }
+
+ private:
+  static const uint16_t MATCHED = 0x8000;
+
+  // Scan table: each entry is the next state's row offset, or MATCHED with
+  // the digit once a pattern ends, since scanning stops there.
+  vector<uint16_t> moves;
+  vector<array<uint8_t, 256>> next;
+  vector<int8_t> output;
+  vector<uint8_t> fail;
+
+  uint8_t add_state() {
+    next.push_back({});
+    output.push_back(-1);
+    fail.push_back(0);
+    return next.size() - 1;
+  }
+
+  // Trie edges point to states above 0; 0 marks a missing edge until compile.
+  void add_pattern(const string& pattern, int digit) {
+    uint8_t state = 0;
+    for (char c : pattern) {
+      uint8_t symbol = static_cast<uint8_t>(c);
+      if (next[state][symbol] == 0) {
+        uint8_t child = add_state();
+        next[state][symbol] = child;
+      }
+      state = next[state][symbol];
+    }
+    output[state] = digit;
+  }
+
+  // Breadth-first, so every failure target is complete before it is used.
+  void compile() {
+    vector<uint8_t> queue;
+    for (uint8_t& edge : next[0])
+      if (edge != 0) queue.push_back(edge);
+    for (size_t head = 0; head < queue.size(); head++) {
+      uint8_t state = queue[head];
+      if (output[state] < 0) output[state] = output[fail[state]];
+      for (int c = 0; c < 256; c++) {
+        uint8_t& edge = next[state][c];
+        if (edge == 0) {
+          edge = next[fail[state]][c];
+        } else {
+          fail[edge] = next[fail[state]][c];
+          queue.push_back(edge);
+        }
+      }
+    }
+
+    moves.resize(next.size() * 256);
+    for (size_t state = 0; state < next.size(); state++)
+      for (int c = 0; c < 256; c++) {
+        uint8_t target = next[state][c];
+        moves[state * 256 + c] =
+          (output[target] >= 0) ? MATCHED | output[target] : target << 8;
+      }
+  }
+};
+
+uint64_t sum_lines(const char* begin, const char* end);
+uint64_t sum_calibration(const char* data, size_t size);
+string synthetic_document(size_t lines);
 
 int main(int argc, char* argv[]) {
-  string user_input = (argc == 2) ? argv[1] : "input";
+  string user_input = (argc >= 2) ? argv[1] : "input";
+  bool bench = (argc >= 3) && string(argv[2]) == "bench";
 
-  ifstream input_file(user_input);
+  MappedFile input_file(user_input);
   if (!input_file.is_open()) {
     cout << "ARQUIVO " << user_input << " INACESSIVEL!" << endl;
     return -1;
   }
 
-  int total = 0;
-  string line;
-  while (getline(input_file, line)) {
-    total = convert_line_to_int(total, line);
+  if (bench) {
+    string document = synthetic_document(1 << 22);
+    auto begin = chrono::steady_clock::now();
+    uint64_t sum = sum_calibration(document.data(), document.size());
+    auto end = chrono::steady_clock::now();
+
+    chrono::duration<double> elapsed = end - begin;
+    cout << "synthetic: " << document.size() / 1e6 << " MB, sum " << sum
+         << ", " << document.size() / elapsed.count() / 1e9 << " GB/s"
+         << endl;
   }
 
+  uint64_t total = sum_calibration(input_file.data(), input_file.size());
   cout << "NUMBER:" << total << "\n";
 
-  input_file.close();
   return 0;
 }
 
-int convert_line_to_int(int total, const string& line) {
-  int first = -1;
-  int last = 0;
-
-  for (string::const_iterator line_it = line.begin(); line_it != line.end();
-       ++line_it) {
-    char c = *line_it;
-    if (isdigit(c)) {
-      last = c - '0';
-      if (-1 == first) { first = last; }
-    } else {
-      for (const pair<unsigned int, string>& num : numbers) {
-        if (strncmp(&line[distance(line.begin(), line_it)], num.second.c_str(),
-                    num.second.length()) == 0) {
-          last = num.first;
-          if (-1 == first) { first = last; }
-        }
-      }
-    }
+const DigitAutomaton forward_digits(false);
+const DigitAutomaton backward_digits(true);
+
+uint64_t sum_lines(const char* begin, const char* end) {
+  uint64_t total = 0;
+  while (begin < end) {
+    const char* newline =
+      static_cast<const char*>(memchr(begin, '\n', end - begin));
+    const char* line_end = newline ? newline : end;
+
+    int first = forward_digits.scan_forward(begin, line_end);
+    if (first >= 0)
+      total += 10 * first + backward_digits.scan_backward(begin, line_end);
+    begin = line_end + 1;
   }
+  return total;
+}
 
-  unsigned long value = 10 * first + last;
-  total += value;
+uint64_t sum_calibration(const char* data, size_t size) {
+  size_t workers = max(1u, thread::hardware_concurrency());
+  workers = min(workers, size / (1 << 16) + 1);
+  vector<const char*> bounds = {data};
+  for (size_t worker = 1; worker < workers; worker++) {
+    const char* cut = max(bounds.back(), data + size * worker / workers);
+    const char* newline =
+      static_cast<const char*>(memchr(cut, '\n', data + size - cut));
+    bounds.push_back(newline ? newline + 1 : data + size);
+  }
+  bounds.push_back(data + size);
 
+  vector<uint64_t> totals(workers);
+  vector<thread> threads;
+  for (size_t worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      totals[worker] = sum_lines(bounds[worker], bounds[worker + 1]);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  uint64_t total = 0;
+  for (uint64_t value : totals)
+    total += value;
   return total;
 }
+
+// Lines of lowercase noise with digits and digit words dropped in.
+string synthetic_document(size_t lines) {
+  mt19937 rng(2023);
+  string document;
+  for (size_t line = 0; line < lines; line++) {
+    for (int piece = 0, pieces = 2 + rng() % 6; piece < pieces; piece++) {
+      switch (rng() % 3) {
+        case 0:
+          document += numbers[rng() % 10];
+          break;
+        case 1:
+          document += '0' + rng() % 10;
+          break;
+        default:
+          for (int noise = rng() % 8; noise > 0; noise--)
+            document += 'a' + rng() % 26;
+      }
+    }
+    document += '\n';
+  }
+  return document;
+}
@@ -24,13 +24,30 @@
  * each color in a set. It calculates the power of each minimum set and sums
  * these values to obtain the final result.
  *
+ * Each game line is walked once over a string_view of the mapped file, keeping
+ * the three color maxima in locals, so the sum of possible game IDs for the
+ * 12/13/14 bag comes out of the same pass as the powers. Large files are split
+ * into line-aligned chunks that are tallied in parallel, and `part2 input
+ * bench` times this on a synthetic file of millions of games.
+ *
  * @author [gabrielzschmitz]
  * @date [02/12/2023]
  */
-#include <cmath>
-#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 using namespace std;
 
@@ -40,132 +57,181 @@ struct Cube {
   int blue;
 };
 
-int get_game_ID(const string& line);
-vector<string> separate_rounds(string line);
-vector<int> get_round_cubes(const string& round);
-unsigned int sumVector(const vector<Cube>& valid_sets);
+const Cube cubes_limit = {12, 13, 14};
+
+struct GameTally {
+  uint64_t possible_IDs = 0;
+  uint64_t powers = 0;
+};
+
+class MappedFile {
+ public:
+  explicit MappedFile(const string& path) : bytes(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0) {
+      if (info.st_size > 0) {
+        void* mapped =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          bytes = static_cast<const char*>(mapped);
+          length = info.st_size;
+        }
+      }
+      // An empty file is open with nothing mapped; a failed mapping is not.
+      opened = info.st_size == 0 || bytes != nullptr;
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool is_open() const { return opened; }
+  const char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+ private:
+  const char* bytes;
+  size_t length;
+  bool opened = false;
+};
+
+Cube scan_game(string_view line, int& ID);
+GameTally tally_games(string_view text);
+GameTally tally_all(const char* data, size_t size);
+string synthetic_games(size_t games);
 
 int main(int argc, char* argv[]) {
-  string user_input = (argc == 2) ? argv[1] : "input";
+  string user_input = (argc >= 2) ? argv[1] : "input";
+  bool bench = (argc >= 3) && string(argv[2]) == "bench";
 
-  ifstream input_file(user_input);
+  MappedFile input_file(user_input);
   if (!input_file.is_open()) {
     cout << "ARQUIVO " << user_input << " INACESSIVEL!" << endl;
     return -1;
   }
 
-  int red_cubes_limit = 12;
-  int green_cubes_limit = 13;
-  int blue_cubes_limit = 14;
-
-  unsigned int total_sets = 0;
-  string line;
-  vector<Cube> valid_sets;
-
-  while (getline(input_file, line)) {
-    vector<string> rounds = separate_rounds(line);
-    Cube minimum = {0, 0, 0};
-    for (const string& round : rounds) {
-      vector<int> cubes = get_round_cubes(round);
-      minimum.red = max(minimum.red, cubes[0]);
-      minimum.green = max(minimum.green, cubes[1]);
-      minimum.blue = max(minimum.blue, cubes[2]);
-    }
+  if (bench) {
+    string games = synthetic_games(1 << 21);
+    auto begin = chrono::steady_clock::now();
+    GameTally tally = tally_all(games.data(), games.size());
+    auto end = chrono::steady_clock::now();
 
-    valid_sets.push_back(minimum);
+    chrono::duration<double> elapsed = end - begin;
+    cout << "synthetic: " << (1 << 21) << " games, IDs " << tally.possible_IDs
+         << ", powers " << tally.powers << ", " << elapsed.count() << "s, "
+         << games.size() / elapsed.count() / 1e9 << " GB/s" << endl;
   }
 
-  total_sets = sumVector(valid_sets);
-  cout << "NUMBER:" << total_sets << "\n";
+  GameTally tally = tally_all(input_file.data(), input_file.size());
+  cout << "POSSIBLE IDS:" << tally.possible_IDs << "\n";
+  cout << "NUMBER:" << tally.powers << "\n";
 
-  // Close the file
-  input_file.close();
   return 0;
 }
 
-int get_game_ID(const string& line) {
-  int ID = -1;
-  char c;
-  int i = 0;
-  string number;
-
-  while (c != ':') {
-    c = line[i];
-    if (isdigit(c)) { number += c; }
-    i++;
+// Reads "Game ID: n color, n color; ..." keeping only each color's maximum;
+// which round a draw belongs to doesn't change the minimum set.
+Cube scan_game(string_view line, int& ID) {
+  size_t i = line.find(' ') + 1;
+  ID = 0;
+  for (; i < line.size() && line[i] != ':'; i++)
+    ID = 10 * ID + (line[i] - '0');
+
+  int red = 0, green = 0, blue = 0;
+  while (i < line.size()) {
+    while (i < line.size() && !isdigit(line[i]))
+      i++;
+    int count = 0;
+    for (; i < line.size() && isdigit(line[i]); i++)
+      count = 10 * count + (line[i] - '0');
+    if (++i >= line.size()) break;
+
+    switch (line[i]) {
+      case 'r':
+        red = max(red, count);
+        i += 3;
+        break;
+      case 'g':
+        green = max(green, count);
+        i += 5;
+        break;
+      case 'b':
+        blue = max(blue, count);
+        i += 4;
+        break;
+    }
   }
-
-  if (!number.empty()) ID = stoi(number);
-  return ID;
+  return {red, green, blue};
 }
 
-vector<string> separate_rounds(string line) {
-  vector<string> rounds;
-  string number;
-
-  line.erase(line.begin(), line.begin() + 7);
-  istringstream raw_input(line);
-
-  string tmp;
-  while (getline(raw_input, tmp, ';'))
-    rounds.push_back(tmp);
-
-  return rounds;
-}
-
-vector<int> get_round_cubes(const string& round) {
-  vector<int> cubes(3, 0);
-
-  size_t redpos = round.find("red");
-  size_t greenpos = round.find("green");
-  size_t bluepos = round.find("blue");
-
-  if (redpos != string::npos) {
-    int i = redpos - 2;
-    int j = 0;
-    while (round[i] != ' ') {
-      int number = (j == 0) ? (round[i] - '0') * pow(10, j)
-                            : cubes[0] + (round[i] - '0') * pow(10, j);
-      cubes[0] = number;
-      i--;
-      j++;
-    }
+GameTally tally_games(string_view text) {
+  GameTally tally;
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    string_view line = text.substr(0, newline);
+    text.remove_prefix(newline == string_view::npos ? text.size()
+                                                    : newline + 1);
+    if (line.empty()) continue;
+
+    int ID;
+    Cube minimum = scan_game(line, ID);
+    if (minimum.red <= cubes_limit.red &&
+        minimum.green <= cubes_limit.green &&
+        minimum.blue <= cubes_limit.blue)
+      tally.possible_IDs += ID;
+    tally.powers += uint64_t(minimum.red) * minimum.green * minimum.blue;
   }
+  return tally;
+}
 
-  if (greenpos != string::npos) {
-    int i = greenpos - 2;
-    int j = 0;
-    while (round[i] != ' ') {
-      int number = (j == 0) ? (round[i] - '0') * pow(10, j)
-                            : cubes[1] + (round[i] - '0') * pow(10, j);
-      cubes[1] = number;
-      i--;
-      j++;
-    }
+GameTally tally_all(const char* data, size_t size) {
+  size_t workers = max(1u, thread::hardware_concurrency());
+  workers = min(workers, size / (1 << 16) + 1);
+  vector<const char*> bounds = {data};
+  for (size_t worker = 1; worker < workers; worker++) {
+    const char* cut = max(bounds.back(), data + size * worker / workers);
+    const char* newline =
+      static_cast<const char*>(memchr(cut, '\n', data + size - cut));
+    bounds.push_back(newline ? newline + 1 : data + size);
   }
-
-  if (bluepos != string::npos) {
-    int i = bluepos - 2;
-    int j = 0;
-    while (round[i] != ' ') {
-      int number = (j == 0) ? (round[i] - '0') * pow(10, j)
-                            : cubes[2] + (round[i] - '0') * pow(10, j);
-      cubes[2] = number;
-      i--;
-      j++;
-    }
+  bounds.push_back(data + size);
+
+  vector<GameTally> tallies(workers);
+  vector<thread> threads;
+  for (size_t worker = 0; worker < workers; worker++)
+    threads.emplace_back([&, worker] {
+      tallies[worker] = tally_games(
+        string_view(bounds[worker], bounds[worker + 1] - bounds[worker]));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  GameTally total;
+  for (const GameTally& tally : tallies) {
+    total.possible_IDs += tally.possible_IDs;
+    total.powers += tally.powers;
   }
-
-  return cubes;
+  return total;
 }
 
-unsigned int sumVector(const vector<Cube>& valid_sets) {
-  unsigned int sum = 0;
-
-  for (const Cube& i : valid_sets) {
-    unsigned int current_set = i.red * i.green * i.blue;
-    sum += current_set;
+string synthetic_games(size_t games) {
+  const char* colors[] = {" red", " green", " blue"};
+  mt19937 rng(2);
+  string text;
+  for (size_t game = 1; game <= games; game++) {
+    text += "Game " + to_string(game) + ":";
+    for (int round = 0, rounds = 1 + rng() % 6; round < rounds; round++) {
+      for (int color = 0; color < 3; color++) {
+        text += (color == 0) ? (round == 0 ? " " : "; ") : ", ";
+        text += to_string(1 + rng() % 20) + colors[color];
+      }
+    }
+    text += '\n';
   }
-
-  return sum;
+  return text;
 }
@@ -33,35 +33,66 @@
  * The program outputs the sum of the gear ratios for all valid gears in the
  * engine. If the input file is inaccessible, an error message is displayed.
  *
- * The program utilizes a struct 'Engine' to store information about each
- * engine, including its ID, position, neighboring special characters, and a
- * marked attribute to track processed engines. It uses vectors to store the
- * identified engines and calculates the gear ratios for valid gears.
+ * Numbers are labeled in one row-major pass over a grid padded with '.', so
+ * no bounds checks are needed. Each number credits the symbols around it, and
+ * a gear keeps the first two numbers that touch it in a small array. The sum
+ * of part numbers and the gear ratios come out of the same O(cells) pass. Only
+ * three rows are ever needed at once, so `part2 input stream` reads the
+ * schematic through a three-row sliding window for files too large for memory.
  *
  * @author [gabrielzschmitz]
  * @date [03/12/2023]
  */
-#include <cmath>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <tuple>
+#include <iterator>
+#include <string>
 #include <vector>
 using namespace std;
 
-struct Engine {
-  vector<tuple<int, int>> especials;
-  tuple<int, int> position;
-  int ID;
-  int marked;
+// The first two numbers next to a '*'; it is a gear if exactly two touch it.
+struct Gear {
+  uint64_t values[2];
+  uint8_t count = 0;
+
+  void add(uint64_t value) {
+    if (count < 2) values[count] = value;
+    if (count < 3) count++;
+  }
+};
+
+struct Totals {
+  uint64_t part_numbers = 0;
+  uint64_t gear_ratios = 0;
+};
+
+/*
+ * Scans padded rows of `width` cells plus a '.' on each side. A row is scanned
+ * once the rows above and below it are available, and the gears of a row are
+ * final once the row below it has been scanned.
+ */
+class SchematicEngine {
+ public:
+  explicit SchematicEngine(size_t width) : width(width) {}
+
+  void scan_row(const char* const rows[3], Gear* const gears[3]);
+  void finish_gears(Gear* gears);
+
+  Totals totals;
+
+ private:
+  size_t width;
 };
 
-vector<tuple<int, int>> check_neighbors(const vector<string>& maps, int ID,
-                                        int IDx, int IDy);
-vector<Engine> search_engines(const vector<string>& maps);
-vector<int> search_gears(const vector<Engine>& engines);
+Totals scan_flat(ifstream& input_file);
+Totals scan_stream(ifstream& input_file);
 
 int main(int argc, char* argv[]) {
-  string user_input = (argc == 2) ? argv[1] : "input";
+  string user_input = (argc >= 2) ? argv[1] : "input";
+  bool stream = (argc >= 3) && string(argv[2]) == "stream";
 
   ifstream input_file(user_input);
   if (!input_file.is_open()) {
@@ -69,123 +100,121 @@ int main(int argc, char* argv[]) {
     return -1;
   }
 
-  int total = 0;
-  string line;
-  vector<string> maps;
-
-  while (getline(input_file, line)) {
-    maps.push_back(line);
-  }
-
-  vector<Engine> engines = search_engines(maps);
-  vector<int> gears = search_gears(engines);
+  Totals totals = stream ? scan_stream(input_file) : scan_flat(input_file);
 
-  for (int i : gears) {
-    total += i;
-  }
-
-  cout << "NUMBER:" << total << "\n";
+  cout << "PART NUMBERS:" << totals.part_numbers << "\n";
+  cout << "NUMBER:" << totals.gear_ratios << "\n";
 
   input_file.close();
   return 0;
 }
 
-vector<tuple<int, int>> check_neighbors(const vector<string>& maps, int ID,
-                                        int IDx, int IDy) {
-  vector<tuple<int, int>> especials;
-
-  // ABOVE
-  if (IDy > 0) {
-    for (int i = IDx; i < IDx + to_string(ID).length(); i++) {
-      if (maps[IDy - 1][i] == '*') { especials.emplace_back(IDy - 1, i); }
-    }
-  }
-
-  // BELOW
-  if (IDy < maps.size() - 1) {
-    for (int i = IDx; i < IDx + to_string(ID).length(); i++) {
-      if (maps[IDy + 1][i] == '*') { especials.emplace_back(IDy + 1, i); }
-    }
-  }
-
-  // LEFT
-  if (IDx > 0) {
-    int ymin = max(0, IDy - 1);
-    int ymax = min(static_cast<int>(maps.size()) - 1, IDy + 1);
-    for (int i = ymin; i <= ymax; i++) {
-      if (maps[i][IDx - 1] == '*') { especials.emplace_back(i, IDx - 1); }
-    }
-  }
-
-  // RIGHT
-  if (IDx + to_string(ID).length() < maps[0].size()) {
-    int ymin = max(0, IDy - 1);
-    int ymax = min(static_cast<int>(maps.size()) - 1, IDy + 1);
-    for (int i = ymin; i <= ymax; i++) {
-      if (maps[i][IDx + to_string(ID).length()] == '*') {
-        especials.emplace_back(i, IDx + to_string(ID).length());
+void SchematicEngine::scan_row(const char* const rows[3],
+                               Gear* const gears[3]) {
+  const char* row = rows[1];
+  for (size_t x = 1; x <= width; x++) {
+    if (!isdigit(row[x])) continue;
+
+    size_t start = x;
+    uint64_t value = 0;
+    for (; isdigit(row[x]); x++)
+      value = value * 10 + (row[x] - '0');
+
+    bool part = false;
+    for (int dy = 0; dy < 3; dy++) {
+      for (size_t nx = start - 1; nx <= x; nx++) {
+        char c = rows[dy][nx];
+        if (c == '.' || isdigit(c)) continue;
+        part = true;
+        if (c == '*') gears[dy][nx].add(value);
       }
     }
+    if (part) totals.part_numbers += value;
   }
-
-  return especials;
 }
 
-vector<Engine> search_engines(const vector<string>& maps) {
-  vector<Engine> engines;
-
-  for (int i = 0; i < maps.size(); i++) {
-    int ID = 0;
-    int positionx = 0;
-    vector<tuple<int, int>> especials;
-
-    for (int j = 0; j < maps[0].size(); j++) {
-      if (isdigit(maps[i][j])) { ID = ID * 10 + (maps[i][j] - '0'); }
-
-      if (j + 1 == maps[0].size() ||
-          (!isdigit(maps[i][j + 1]) && isdigit(maps[i][j]))) {
-        positionx = j - to_string(ID).length() + 1;
-        especials = check_neighbors(maps, ID, positionx, i);
-
-        if (!especials.empty()) {
-          engines.push_back({especials, {positionx, i}, ID, -1});
-        }
-
-        ID = 0;
-      }
-    }
+void SchematicEngine::finish_gears(Gear* gears) {
+  for (size_t x = 0; x < width + 2; x++) {
+    if (gears[x].count == 2)
+      totals.gear_ratios += gears[x].values[0] * gears[x].values[1];
+    gears[x].count = 0;
   }
-
-  return engines;
 }
 
-vector<int> search_gears(const vector<Engine>& engines) {
-  vector<int> gears;
-
-  for (const Engine& engine : engines) {
-    int engineID = engine.ID;
+// Copies `line` into a padded row, cutting or padding it to the row's width.
+void pad_row(const string& line, char* row, size_t width) {
+  for (size_t x = 0; x < width; x++)
+    row[x + 1] = (x < line.size()) ? line[x] : '.';
+}
 
-    for (const tuple<int, int>& neighborPosition : engine.especials) {
-      int neighborID = -1;
-      int neighborCount = 0;
-      int neighborY = get<1>(neighborPosition);
-      int neighborX = get<0>(neighborPosition);
+// Gears only need the three rows around the one being scanned, so their
+// slots are recycled the same way scan_stream does.
+Totals scan_flat(ifstream& input_file) {
+  string text((istreambuf_iterator<char>(input_file)),
+              istreambuf_iterator<char>());
+  vector<pair<size_t, size_t>> lines;
+  size_t width = 0;
+  for (size_t start = 0; start < text.size();) {
+    size_t end = min(text.find('\n', start), text.size());
+    lines.emplace_back(start, end - start);
+    width = max(width, end - start);
+    start = end + 1;
+  }
 
-      for (const Engine& neighborEngine : engines) {
-        if (get<1>(neighborEngine.especials[0]) == neighborY &&
-            get<0>(neighborEngine.especials[0]) == neighborX) {
-          neighborID = neighborEngine.ID;
-          neighborCount += 1;
-        }
-      }
+  size_t stride = width + 2;
+  vector<char> grid((lines.size() + 2) * stride, '.');
+  for (size_t y = 0; y < lines.size(); y++)
+    copy_n(&text[lines[y].first], lines[y].second, &grid[(y + 1) * stride + 1]);
+  string().swap(text);
+
+  vector<vector<Gear>> gears(3, vector<Gear>(stride));
+  SchematicEngine engine(width);
+  for (size_t y = 1; y <= lines.size(); y++) {
+    const char* rows[3] = {&grid[(y - 1) * stride], &grid[y * stride],
+                           &grid[(y + 1) * stride]};
+    Gear* row_gears[3] = {gears[(y - 1) % 3].data(), gears[y % 3].data(),
+                          gears[(y + 1) % 3].data()};
+    engine.scan_row(rows, row_gears);
+    engine.finish_gears(row_gears[0]);
+  }
+  engine.finish_gears(gears[lines.size() % 3].data());
+  return engine.totals;
+}
 
-      if (neighborID != -1 && neighborCount == 2 && engine.marked == -1 &&
-          engineID != neighborID) {
-        gears.push_back(engineID * neighborID);
-        const_cast<Engine&>(engine).marked = 1;  // Mark the engine as processed
-      }
-    }
+/*
+ * Row y lives in slot y % 3 of the window. Reading row y scans row y - 1 and
+ * finishes the gears of row y - 2, whose slot row y + 1 then reuses. The
+ * width comes from the first line.
+ */
+Totals scan_stream(ifstream& input_file) {
+  string line;
+  if (!getline(input_file, line)) return {};
+
+  size_t width = line.size(), stride = width + 2;
+  vector<string> window(3, string(stride, '.'));
+  vector<vector<Gear>> gears(3, vector<Gear>(stride));
+  SchematicEngine engine(width);
+
+  auto advance = [&](size_t y) {
+    const char* rows[3] = {window[(y + 1) % 3].data(),
+                           window[(y + 2) % 3].data(), window[y % 3].data()};
+    Gear* row_gears[3] = {gears[(y + 1) % 3].data(),
+                          gears[(y + 2) % 3].data(), gears[y % 3].data()};
+    engine.scan_row(rows, row_gears);
+    engine.finish_gears(row_gears[0]);
+  };
+
+  size_t y = 1;
+  pad_row(line, &window[y % 3][0], width);
+  while (getline(input_file, line)) {
+    y++;
+    pad_row(line, &window[y % 3][0], width);
+    advance(y);
   }
 
-  return gears;
+  y++;
+  window[y % 3].assign(stride, '.');
+  advance(y);
+  engine.finish_gears(gears[(y + 2) % 3].data());
+  return engine.totals;
 }